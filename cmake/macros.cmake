@@ -43,6 +43,14 @@ macro(chat_add_sanitizers target)
     endif()
 endmacro()
 
+#Define CHAT_LOCK_PROFILING for a target if locks are profiled
+#Usage: chat_add_lock_profiling(<target>)
+macro(chat_add_lock_profiling target)
+    if(${CHAT_ENABLE_LOCK_PROFILING})
+        target_compile_definitions(${target} PUBLIC CHAT_LOCK_PROFILING)
+    endif()
+endmacro()
+
 #Add a target for a library
 #Usage: chat_add_library(<name>)
 macro(chat_add_library library_name)
@@ -51,6 +59,7 @@ macro(chat_add_library library_name)
 
     chat_add_compiler_warnings(${library_name})
     chat_add_sanitizers(${library_name})
+    chat_add_lock_profiling(${library_name})
 endmacro()
 
 #Add a target for an application
@@ -60,6 +69,7 @@ macro(chat_add_app app_name)
 
     chat_add_compiler_warnings(${app_name})
     chat_add_sanitizers(${app_name})
+    chat_add_lock_profiling(${app_name})
 endmacro()
 
 #Add a target for a test
@@ -69,6 +79,7 @@ macro(chat_add_test test_name)
 
     chat_add_compiler_warnings(${test_name})
     chat_add_sanitizers(${test_name})
+    chat_add_lock_profiling(${test_name})
     target_compile_options(${test_name} PUBLIC -g)
 
     #Use Catch2 library
@@ -3,3 +3,4 @@ chat_option(CHAT_ENABLE_ASAN "Enable address sanitizer" off)
 chat_option(CHAT_ENABLE_TSAN "Enable thread sanitizer" off)
 chat_option(CHAT_ENABLE_UBSAN "Enable undefined sanitizer" off)
 chat_option(CHAT_ENABLE_LSAN "Enable leak sanitizer" off)
+chat_option(CHAT_ENABLE_LOCK_PROFILING "Profile how long named locks wait and are held" off)
@@ -1,7 +1,11 @@
+#include "chat/common/LockProfiling.hpp"
 #include "chat/common/Logging.hpp"
 #include "chat/common/Port.hpp"
+#include "chat/common/affinity.hpp"
+#include "chat/server/Config.hpp"
 #include "chat/server/Server.hpp"
 
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <filesystem>
@@ -9,6 +13,7 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace
@@ -18,8 +23,32 @@ struct Options
     std::optional<std::filesystem::path> logFilePath;
     chat::common::Port port{25565};
     std::size_t maxThreadCount = 2;
+    chat::server::Config config;
 };
 
+chat::server::IdleProfile parseIdleProfile(const std::string& arg)
+{
+    if(arg == "power-saving") {
+        return chat::server::IdleProfile::PowerSaving;
+    }
+
+    if(arg == "low-latency") {
+        return chat::server::IdleProfile::LowLatency;
+    }
+
+    throw std::invalid_argument{"unexpected idle profile"};
+}
+
+chat::common::affinity::CpuSet parseCpuList(const std::string& arg)
+{
+    auto cpus = chat::common::affinity::parseCpuList(arg);
+    if(!cpus.has_value()) {
+        throw std::invalid_argument{"unexpected cpu list"};
+    }
+
+    return std::move(cpus.value());
+}
+
 Options parseOptions(const std::vector<std::string>& args)
 {
     Options options;
@@ -37,6 +66,48 @@ Options parseOptions(const std::vector<std::string>& args)
         } else if(arg == "--max-thread-count") {
             options.maxThreadCount = std::stoi(args.at(i + 1));
             i++;
+        } else if(arg == "--min-thread-count") {
+            options.config.minWorkerThreadCount = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--queue-wait-target-ms") {
+            options.config.workerQueueWaitTarget =
+                std::chrono::milliseconds{std::stol(args.at(i + 1))};
+            i++;
+        } else if(arg == "--thread-idle-timeout-ms") {
+            options.config.workerIdleTimeout =
+                std::chrono::milliseconds{std::stol(args.at(i + 1))};
+            i++;
+        } else if(arg == "--min-receive-buffer-size") {
+            options.config.minReceiveBufferSize = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--max-receive-buffer-size") {
+            options.config.maxReceiveBufferSize = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--receive-buffer-idle-timeout-ms") {
+            options.config.receiveBufferIdleTimeout =
+                std::chrono::milliseconds{std::stol(args.at(i + 1))};
+            i++;
+        } else if(arg == "--receive-ring-capacity") {
+            options.config.receiveRingCapacity = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--io-thread-count") {
+            options.config.ioThreadCount = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--send-high-water-mark") {
+            options.config.sendHighWaterMark = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--send-low-water-mark") {
+            options.config.sendLowWaterMark = std::stoul(args.at(i + 1));
+            i++;
+        } else if(arg == "--idle-profile") {
+            options.config.idleProfile = parseIdleProfile(args.at(i + 1));
+            i++;
+        } else if(arg == "--io-thread-cpus") {
+            options.config.ioThreadCpus = parseCpuList(args.at(i + 1));
+            i++;
+        } else if(arg == "--worker-thread-cpus") {
+            options.config.workerThreadCpus = parseCpuList(args.at(i + 1));
+            i++;
         } else {
             throw std::invalid_argument{"unexpected argument"};
         }
@@ -58,8 +129,13 @@ int main(int argc, char* argv[])
                 fileLogger.emplace(options.logFilePath.value(), true));
         }
 
-        chat::server::Server server(options.port, options.maxThreadCount);
+        chat::server::Server server(options.port, options.maxThreadCount,
+                                    options.config);
         server.run();
+
+        // Profiled builds report which locks were contended while the logger
+        // is still alive
+        chat::common::logLockStats();
     } catch(const std::exception& exception) {
         LOG_FATAL("Exception caught: {}", exception.what());
         return 1;
@@ -3,10 +3,12 @@
 #include "chat/common/Port.hpp"
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace chat::client
 {
@@ -63,6 +65,23 @@ public:
      */
     [[nodiscard]] std::optional<std::chrono::milliseconds> ping();
 
+    /**
+     * @brief Get the elapsed times for making multiple requests and receiving
+     * their responses.
+     *
+     * @details The requests are pipelined, meaning a request is sent without
+     * waiting for the responses to the requests before it. This lets many
+     * requests complete in a single round trip. The responses are matched to
+     * the requests by their correlation IDs.
+     *
+     * @param count The number of requests to make.
+     *
+     * @return The elapsed time for each request, in the order the requests
+     * were made.
+     */
+    [[nodiscard]] std::optional<std::vector<std::chrono::milliseconds>> ping(
+        std::size_t count);
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
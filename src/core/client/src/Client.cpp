@@ -1,8 +1,11 @@
 #include "chat/client/Client.hpp"
+#include "chat/common/Buffer.hpp"
 #include "chat/common/BufferView.hpp"
+#include "chat/common/InputByteStream.hpp"
 #include "chat/common/Logging.hpp"
 #include "chat/common/Port.hpp"
 #include "chat/common/utility.hpp"
+#include "chat/messages/CorrelationId.hpp"
 #include "chat/messages/Request.hpp"
 #include "chat/messages/Response.hpp"
 #include "chat/messages/request/Ping.hpp"
@@ -10,15 +13,17 @@
 #include "chat/messages/serialize.hpp"
 
 #include <SFML/Network/IpAddress.hpp>
-#include <SFML/Network/Packet.hpp>
 #include <SFML/Network/Socket.hpp>
 #include <SFML/Network/TcpSocket.hpp>
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace chat::client
 {
@@ -30,14 +35,26 @@ public:
       : m_host{host},
         m_port{port},
         m_socket{},
-        m_connected{false}
+        m_connected{false},
+        m_nextCorrelationId{0}
     {
         m_socket.setBlocking(true);
     }
 
     [[nodiscard]] std::optional<std::chrono::milliseconds> ping()
     {
-        LOG_DEBUG("Sending ping...");
+        auto elapsed = ping(1);
+        if(!elapsed.has_value()) {
+            return std::nullopt;
+        }
+
+        return elapsed.value().front();
+    }
+
+    [[nodiscard]] std::optional<std::vector<std::chrono::milliseconds>> ping(
+        std::size_t count)
+    {
+        LOG_DEBUG("Sending {} pings...", count);
 
         //`sendAndReceive()` is not used here so that establishing a connection
         // is not included in the elapsed time measurement
@@ -46,23 +63,69 @@ public:
             return std::nullopt;
         }
 
-        std::optional<std::chrono::milliseconds> result;
-        auto start = std::chrono::system_clock::now();
-        if(sendRequest(messages::Ping{})) {
-            if(receiveResponse<messages::Pong, messages::Response::Type::Pong>()
-                   .has_value()) {
-                auto end = std::chrono::system_clock::now();
-                result = std::make_optional(
-                    std::chrono::duration_cast<std::chrono::milliseconds>(
-                        end - start));
+        // The pings are pipelined: a ping is sent without waiting for the
+        // responses to the previous ones. The number of pings in flight is
+        // limited since this thread doesn't receive while it sends, and the
+        // server stops receiving once its responses can't be sent.
+        const messages::CorrelationId firstCorrelationId = m_nextCorrelationId;
+        m_nextCorrelationId += static_cast<messages::CorrelationId>(count);
+        std::vector<std::chrono::system_clock::time_point> starts(count);
+        std::vector<std::chrono::milliseconds> elapsed(count);
+        std::vector<bool> answered(count, false);
+        std::size_t sentCount = 0;
+        std::size_t receivedCount = 0;
+        bool success = true;
+        while(success && receivedCount < count) {
+            if(sentCount < count &&
+               sentCount - receivedCount < maxInFlightCount) {
+                messages::Ping request;
+                request.setCorrelationId(
+                    firstCorrelationId +
+                    static_cast<messages::CorrelationId>(sentCount));
+                starts.at(sentCount) = std::chrono::system_clock::now();
+                success = sendRequest(request);
+                sentCount++;
+                continue;
             }
+
+            auto response = receiveResponse<messages::Pong,
+                                            messages::Response::Type::Pong>();
+            if(!response.has_value()) {
+                success = false;
+                break;
+            }
+
+            // Responses can arrive in any order, so the correlation ID is used
+            // to find the ping a response answers
+            const std::size_t index = static_cast<messages::CorrelationId>(
+                response.value()->getCorrelationId() - firstCorrelationId);
+            if(index >= sentCount || answered.at(index)) {
+                LOG_ERROR("Received response with unexpected correlation ID");
+                success = false;
+                break;
+            }
+
+            answered.at(index) = true;
+            elapsed.at(index) =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now() - starts.at(index));
+            receivedCount++;
+        }
+
+        if(!success) {
+            // Responses that are still in flight would be mistaken for the
+            // responses of later requests, so start over with a new connection
+            disconnect();
         }
 
-        LOG_DEBUG("Finished ping");
-        return result;
+        LOG_DEBUG("Finished pings");
+        return success ? std::make_optional(std::move(elapsed)) : std::nullopt;
     }
 
 private:
+    // The maximum number of requests sent without receiving their responses
+    static constexpr std::size_t maxInFlightCount = 64;
+
     [[nodiscard]] bool connect()
     {
         LOG_DEBUG("Connecting to host...");
@@ -107,26 +170,33 @@ private:
         return success;
     }
 
-    [[nodiscard]] bool sendPacket(sf::Packet& packet)
+    void disconnect()
+    {
+        LOG_DEBUG("Disconnecting from host");
+        m_socket.disconnect();
+        m_connected = false;
+    }
+
+    [[nodiscard]] bool sendBytes(const common::BufferView& bytes)
     {
-        LOG_DEBUG("Sending packet...");
+        LOG_DEBUG("Sending bytes...");
 
         bool success = false;
-        switch(m_socket.send(packet)) {
+        switch(m_socket.send(bytes.data(), bytes.size())) {
         case sf::Socket::Status::Done:
-            LOG_DEBUG("Packet sent");
+            LOG_DEBUG("Bytes sent");
             success = true;
             break;
 
         case sf::Socket::Status::NotReady:
             LOG_WARN(
-                "Could not send request, unexpected "
+                "Could not send bytes, unexpected "
                 "`sf::Socket::Status::NotReady`");
             break;
 
         case sf::Socket::Status::Partial:
             LOG_WARN(
-                "Could not send request, unexpected "
+                "Could not send bytes, unexpected "
                 "`sf::Socket::Status::Partial`");
             break;
 
@@ -134,58 +204,94 @@ private:
             // This should not happen:
             // https://stackoverflow.com/a/14782354/21445636
             LOG_WARN(
-                "Could not send request, unexpected "
+                "Could not send bytes, unexpected "
                 "`sf::Socket::Status::Disconnect`");
             m_connected = false;
             break;
 
         case sf::Socket::Status::Error:
-            LOG_WARN("An error occured while trying to send request");
+            LOG_WARN("An error occured while trying to send bytes");
             break;
         }
 
-        LOG_DEBUG("Finished sending packet");
+        LOG_DEBUG("Finished sending bytes");
         return success;
     }
 
-    [[nodiscard]] std::optional<sf::Packet> receivePacket()
+    [[nodiscard]] std::optional<common::Buffer> receiveBytes(std::size_t count)
     {
-        LOG_DEBUG("Receiving packet...");
-
-        bool success = false;
-        sf::Packet packet;
-        switch(m_socket.receive(packet)) {
-        case sf::Socket::Status::Done:
-            LOG_DEBUG("Packet received");
-            success = true;
-            break;
+        LOG_DEBUG("Receiving bytes...");
+
+        // A receive returns as soon as some bytes are available, so it is
+        // repeated until all the bytes are received
+        bool success = true;
+        common::Buffer bytes(count);
+        std::size_t receivedCount = 0;
+        while(success && receivedCount < count) {
+            std::size_t received = 0;
+            switch(m_socket.receive(bytes.data() + receivedCount,
+                                    count - receivedCount, received)) {
+            case sf::Socket::Status::Done:
+                receivedCount += received;
+                break;
+
+            case sf::Socket::Status::NotReady:
+                LOG_WARN(
+                    "Could not receive bytes, unexpected "
+                    "`sf::Socket::Status::NotReady`");
+                success = false;
+                break;
+
+            case sf::Socket::Status::Partial:
+                LOG_WARN(
+                    "Could not receive bytes, unexpected "
+                    "`sf::Socket::Status::Partial`");
+                success = false;
+                break;
+
+            case sf::Socket::Status::Disconnected:
+                LOG_WARN(
+                    "Could not receive bytes since the socket is "
+                    "disconnected");
+                m_connected = false;
+                success = false;
+                break;
+
+            case sf::Socket::Status::Error:
+                LOG_WARN("An error occured while trying to receive bytes");
+                success = false;
+                break;
+            }
+        }
 
-        case sf::Socket::Status::NotReady:
-            LOG_WARN(
-                "Could not receive request, unexpected "
-                "`sf::Socket::Status::NotReady`");
-            break;
+        LOG_DEBUG("Finished receiving bytes");
+        return success ? std::make_optional(std::move(bytes)) : std::nullopt;
+    }
 
-        case sf::Socket::Status::Partial:
-            LOG_WARN(
-                "Could not receive request, unexpected "
-                "`sf::Socket::Status::Partial`");
-            break;
+    [[nodiscard]] std::optional<common::Buffer> receiveFrame()
+    {
+        // A frame is a serialized message, which starts with the size of the
+        // rest of the message
+        auto frame = receiveBytes(sizeof(std::uint32_t));
+        if(!frame.has_value()) {
+            return std::nullopt;
+        }
 
-        case sf::Socket::Status::Disconnected:
-            LOG_WARN(
-                "Could not receive request since the socket is "
-                "disconnected");
-            m_connected = false;
-            break;
+        common::InputByteStream stream{
+            common::BufferView{frame.value().data(), frame.value().size()}};
+        std::uint32_t size = 0;
+        if(!(stream >> size)) {
+            return std::nullopt;
+        }
 
-        case sf::Socket::Status::Error:
-            LOG_WARN("An error occured while trying to receive request");
-            break;
+        auto rest = receiveBytes(size);
+        if(!rest.has_value()) {
+            return std::nullopt;
         }
 
-        LOG_DEBUG("Finished receiving packet");
-        return success ? std::make_optional(packet) : std::nullopt;
+        frame.value().insert(frame.value().end(), rest.value().begin(),
+                             rest.value().end());
+        return frame;
     }
 
     [[nodiscard]] bool sendRequest(const messages::Request& request)
@@ -193,9 +299,8 @@ private:
         LOG_DEBUG("Sending request...");
 
         auto serialized = messages::serialize(request);
-        sf::Packet packet;
-        packet.append(serialized.data(), serialized.size());
-        const bool success = sendPacket(packet);
+        const bool success = sendBytes(
+            common::BufferView{serialized.data(), serialized.size()});
 
         LOG_DEBUG("Finished sending request");
         return success;
@@ -211,10 +316,9 @@ private:
         LOG_DEBUG("Receiving response...");
 
         std::optional<std::unique_ptr<ResponseType>> response;
-        if(auto packet = receivePacket(); packet.has_value()) {
-            const common::BufferView serialized{
-                static_cast<const std::byte*>(packet.value().getData()),
-                packet.value().getDataSize()};
+        if(auto frame = receiveFrame(); frame.has_value()) {
+            const common::BufferView serialized{frame.value().data(),
+                                                frame.value().size()};
             if(auto message = messages::deserializeResponse(serialized);
                message.has_value()) {
                 // The message is placed inside an `std::unique_ptr`. There is
@@ -255,6 +359,7 @@ private:
     common::Port m_port;
     sf::TcpSocket m_socket;
     bool m_connected;
+    messages::CorrelationId m_nextCorrelationId;
 };
 
 Client::Client(const std::string& host, common::Port port)
@@ -268,4 +373,10 @@ std::optional<std::chrono::milliseconds> Client::ping()
     return m_impl->ping();
 }
 
+std::optional<std::vector<std::chrono::milliseconds>> Client::ping(
+    std::size_t count)
+{
+    return m_impl->ping(count);
+}
+
 }
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "chat/common/Buffer.hpp"
+#include "chat/common/BufferView.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+namespace chat::common
+{
+
+/**
+ * @brief A lock-free ring buffer of bytes for a single producer and a single
+ * consumer.
+ *
+ * @details The producer writes bytes into the free space of the ring, and the
+ * consumer reads bytes from the used space of the ring. Both can run at the
+ * same time on different threads without locking. Only one thread may produce
+ * and only one thread may consume at a time.
+ *
+ * Writing and reading are done in two steps to avoid copying. The producer gets
+ * a contiguous span of free space, fills it, and commits the number of bytes
+ * written. The consumer gets a contiguous span of used space, reads it, and
+ * commits the number of bytes read. Since the space can wrap around the end of
+ * the ring, a span might not cover all the free or used space, in which case
+ * the remaining space is available at the start of the ring after committing.
+ *
+ * The capacity is rounded up to a power of 2 so that positions in the ring are
+ * found with a mask rather than a division. The write and read positions only
+ * ever increase, which lets a full ring be told apart from an empty one without
+ * wasting a byte.
+ */
+class ByteRing
+{
+public:
+    /**
+     * @brief Construct a ring.
+     *
+     * @param capacity The minimum number of bytes the ring can hold. It's
+     * rounded up to the next power of 2.
+     */
+    explicit ByteRing(std::size_t capacity);
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    ByteRing(const ByteRing& other) = delete;
+    ByteRing& operator=(const ByteRing& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    ByteRing(ByteRing&& other) = delete;
+    ByteRing& operator=(ByteRing&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the ring.
+     */
+    ~ByteRing() = default;
+
+    /**
+     * @brief Get the number of bytes the ring can hold.
+     *
+     * @return The number of bytes the ring can hold.
+     */
+    [[nodiscard]] std::size_t getCapacity() const;
+
+    /**
+     * @brief Get the contiguous free space to write into.
+     *
+     * @details This must only be called by the producer.
+     *
+     * @return The contiguous free space, starting from the write position. It's
+     * empty if the ring is full.
+     */
+    [[nodiscard]] std::span<std::byte> getWritable();
+
+    /**
+     * @brief Make written bytes available to the consumer.
+     *
+     * @details This must only be called by the producer.
+     *
+     * @param count The number of bytes written to the start of the span
+     * returned by @c getWritable(). It must not be greater than the size of the
+     * span.
+     */
+    void commitWrite(std::size_t count);
+
+    /**
+     * @brief Copy as many bytes as fit into the ring.
+     *
+     * @details This must only be called by the producer. The bytes are written
+     * on both sides of the end of the ring when needed.
+     *
+     * @param data The bytes to copy.
+     *
+     * @return The number of bytes copied, starting from the start of the data.
+     */
+    std::size_t write(const BufferView& data);
+
+    /**
+     * @brief Get the contiguous used space to read from.
+     *
+     * @details This must only be called by the consumer.
+     *
+     * @return The contiguous used space, starting from the read position. It's
+     * empty if the ring is empty.
+     */
+    [[nodiscard]] BufferView getReadable();
+
+    /**
+     * @brief Make read bytes available to the producer.
+     *
+     * @details This must only be called by the consumer.
+     *
+     * @param count The number of bytes read from the start of the span
+     * returned by @c getReadable(). It must not be greater than the size of the
+     * span.
+     */
+    void commitRead(std::size_t count);
+
+private:
+    // Keeps the positions owned by the producer and the consumer on separate
+    // cache lines so that they don't invalidate each other's cache line
+    static constexpr std::size_t cacheLineSize = 64;
+
+    std::size_t m_capacity;
+    std::size_t m_mask;
+    Buffer m_data;
+
+    // Written by the producer
+    alignas(cacheLineSize) std::atomic_size_t m_writePosition;
+    std::size_t m_cachedReadPosition;
+
+    // Written by the consumer
+    alignas(cacheLineSize) std::atomic_size_t m_readPosition;
+    std::size_t m_cachedWritePosition;
+};
+
+}
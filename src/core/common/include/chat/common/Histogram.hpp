@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace chat::common
+{
+
+/**
+ * @brief A histogram of unsigned integer values, such as durations in
+ * nanoseconds.
+ *
+ * @details Values are counted in buckets whose width grows with the value:
+ * values below 8 have a bucket each, and every power of 2 above that is split
+ * into 8 buckets. A bucket is therefore at most 12.5% wide relative to its
+ * values, and the whole range of `std::uint64_t` fits in a fixed number of
+ * buckets.
+ *
+ * Only one thread may record values into a histogram, which lets recording use
+ * plain atomic loads and stores rather than read-modify-write operations. Any
+ * thread may take a snapshot at any time. A snapshot taken while values are
+ * being recorded might be missing the latest values.
+ */
+class Histogram
+{
+public:
+    /**
+     * @brief The number of buckets.
+     */
+    static constexpr std::size_t bucketCount = 496;
+
+    /**
+     * @brief The counts of a histogram at one point in time.
+     *
+     * @details Snapshots of several histograms, such as one per thread, can be
+     * merged into one.
+     */
+    class Snapshot
+    {
+    public:
+        /**
+         * @brief Add the counts of another snapshot.
+         *
+         * @param other The other snapshot.
+         */
+        void merge(const Snapshot& other);
+
+        /**
+         * @brief Get the number of recorded values.
+         *
+         * @return The number of values.
+         */
+        [[nodiscard]] std::uint64_t getCount() const;
+
+        /**
+         * @brief Get the sum of the recorded values.
+         *
+         * @details The sum wraps around if it doesn't fit.
+         *
+         * @return The sum.
+         */
+        [[nodiscard]] std::uint64_t getSum() const;
+
+        /**
+         * @brief Get a value that a percentage of the recorded values are at or
+         * below.
+         *
+         * @details The value is the upper bound of the bucket the percentile
+         * falls in, so it's never less than the true percentile.
+         *
+         * @param percentile The percentage, from 0 to 100.
+         *
+         * @return The value, or 0 if no values were recorded.
+         */
+        [[nodiscard]] std::uint64_t getPercentile(double percentile) const;
+
+    private:
+        friend class Histogram;
+
+        std::array<std::uint64_t, bucketCount> m_counts{};
+        std::uint64_t m_count = 0;
+        std::uint64_t m_sum = 0;
+    };
+
+    /**
+     * @brief Record a value.
+     *
+     * @details Only one thread may record values into the histogram.
+     *
+     * @param value The value.
+     */
+    void record(std::uint64_t value);
+
+    /**
+     * @brief Take a snapshot of the counts.
+     *
+     * @return The snapshot.
+     */
+    [[nodiscard]] Snapshot getSnapshot() const;
+
+private:
+    /**
+     * @brief Get the bucket of a value.
+     *
+     * @param value The value.
+     *
+     * @return The index of the bucket.
+     */
+    [[nodiscard]] static std::size_t getBucket(std::uint64_t value);
+
+    /**
+     * @brief Get the largest value of a bucket.
+     *
+     * @param bucket The index of the bucket.
+     *
+     * @return The largest value.
+     */
+    [[nodiscard]] static std::uint64_t getUpperBound(std::size_t bucket);
+
+    std::array<std::atomic_uint64_t, bucketCount> m_counts{};
+    std::atomic_uint64_t m_sum = 0;
+};
+
+}
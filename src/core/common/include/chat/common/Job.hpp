@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace chat::common
+{
+
+/**
+ * @brief A function to run on a thread, stored without allocating.
+ *
+ * @details Unlike `std::function`, a job stores the function object in a fixed
+ * amount of inline storage and never allocates. A function object that doesn't
+ * fit fails to compile, so large captures have to be moved behind a pointer
+ * explicitly rather than silently costing an allocation. A job is move-only,
+ * which lets it hold move-only captures such as `std::unique_ptr`s.
+ */
+class Job
+{
+public:
+    /**
+     * @brief The largest function object a job can store.
+     *
+     * @details This fits a `std::shared_ptr` plus four more pointer-sized
+     * captures.
+     */
+    static constexpr std::size_t inlineSize = 48;
+
+    /**
+     * @brief Construct an empty job.
+     */
+    Job() = default;
+
+    /**
+     * @brief Construct a job from a function object.
+     *
+     * @tparam Function The type of the function object.
+     *
+     * @param function The function object to store.
+     */
+    template<typename Function>
+        requires(!std::is_same_v<std::remove_cvref_t<Function>, Job> &&
+                 std::is_invocable_r_v<void, std::decay_t<Function>&>)
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    Job(Function&& function)
+    {
+        using Stored = std::decay_t<Function>;
+        static_assert(sizeof(Stored) <= inlineSize,
+                      "The function object is too large for a job, so move "
+                      "its captures behind a pointer");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t),
+                      "The function object is over-aligned for a job");
+        static_assert(std::is_nothrow_move_constructible_v<Stored>,
+                      "The function object must be nothrow movable");
+
+        ::new(static_cast<void*>(m_storage.data()))
+            Stored(std::forward<Function>(function));
+        m_operations = &operations<Stored>;
+    }
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    Job(const Job& other) = delete;
+    Job& operator=(const Job& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move construct a job.
+     *
+     * @details The other job is left empty.
+     *
+     * @param other The job to move from.
+     */
+    Job(Job&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    /**
+     * @brief Move assign a job.
+     *
+     * @details The other job is left empty.
+     *
+     * @param other The job to move from.
+     *
+     * @return This job.
+     */
+    Job& operator=(Job&& other) noexcept
+    {
+        if(this != &other) {
+            reset();
+            moveFrom(other);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Destroy the job.
+     */
+    ~Job()
+    {
+        reset();
+    }
+
+    /**
+     * @brief Run the function.
+     *
+     * @details The job must not be empty.
+     */
+    void operator()()
+    {
+        m_operations->invoke(m_storage.data());
+    }
+
+    /**
+     * @brief Check if the job stores a function.
+     *
+     * @return True if the job stores a function; otherwise, false.
+     */
+    explicit operator bool() const
+    {
+        return m_operations != nullptr;
+    }
+
+    /**
+     * @brief Destroy the stored function, leaving the job empty.
+     */
+    void reset()
+    {
+        if(m_operations != nullptr) {
+            m_operations->destroy(m_storage.data());
+            m_operations = nullptr;
+        }
+    }
+
+private:
+    /**
+     * @brief The operations on a stored function object of a given type.
+     */
+    struct Operations
+    {
+        void (*invoke)(void* function);
+        void (*relocate)(void* to, void* from) noexcept;
+        void (*destroy)(void* function) noexcept;
+    };
+
+    template<typename Stored>
+    static constexpr Operations operations{
+        [](void* function) { (*static_cast<Stored*>(function))(); },
+        [](void* to, void* from) noexcept {
+            auto* stored = static_cast<Stored*>(from);
+            ::new(to) Stored(std::move(*stored));
+            stored->~Stored();
+        },
+        [](void* function) noexcept {
+            static_cast<Stored*>(function)->~Stored();
+        },
+    };
+
+    /**
+     * @brief Take the function of another job.
+     *
+     * @details This job must be empty. The other job is left empty.
+     *
+     * @param other The job to take the function from.
+     */
+    void moveFrom(Job& other) noexcept
+    {
+        if(other.m_operations != nullptr) {
+            other.m_operations->relocate(m_storage.data(),
+                                         other.m_storage.data());
+            m_operations = std::exchange(other.m_operations, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) std::array<std::byte, inlineSize> m_storage{};
+    const Operations* m_operations = nullptr;
+};
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "chat/common/Histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chat::common
+{
+
+/**
+ * @brief Whether locks are profiled.
+ *
+ * @details Profiling is enabled by building with `CHAT_LOCK_PROFILING`
+ * defined, which the `CHAT_ENABLE_LOCK_PROFILING` CMake option does for every
+ * target. Otherwise, naming a lock costs nothing.
+ */
+#if defined(CHAT_LOCK_PROFILING)
+inline constexpr bool isLockProfilingEnabled = true;
+#else
+inline constexpr bool isLockProfilingEnabled = false;
+#endif
+
+/**
+ * @brief The name a lock is profiled under.
+ *
+ * @details Locks with the same name, such as the same lock of every
+ * connection, are reported together.
+ */
+struct LockName
+{
+    std::string_view value;
+};
+
+/**
+ * @brief How a lock has been used since the application started.
+ */
+struct LockStats
+{
+    /**
+     * @brief The name of the lock.
+     */
+    std::string name;
+
+    /**
+     * @brief The number of times the lock was acquired.
+     */
+    std::uint64_t acquireCount = 0;
+
+    /**
+     * @brief The number of times the lock was already held by another thread
+     * when it was acquired.
+     */
+    std::uint64_t contendedCount = 0;
+
+    /**
+     * @brief How long it took to acquire the lock, in nanoseconds.
+     *
+     * @details An acquisition that wasn't contended is recorded as 0.
+     */
+    Histogram::Snapshot wait;
+
+    /**
+     * @brief How long the lock was held, in nanoseconds.
+     */
+    Histogram::Snapshot hold;
+};
+
+/**
+ * @brief Get how every named lock has been used.
+ *
+ * @details Locks that have been destroyed are included.
+ *
+ * @return The stats of each name, sorted by name, or nothing if locks aren't
+ * profiled.
+ */
+[[nodiscard]] std::vector<LockStats> getLockStats();
+
+/**
+ * @brief Log how every named lock has been used.
+ *
+ * @details Nothing is logged if locks aren't profiled.
+ */
+void logLockStats();
+
+namespace detail
+{
+/**
+ * @brief Records how a single lock is used.
+ *
+ * @details The profile of a lock is only written to while the lock is held,
+ * which serializes the writes to its histograms.
+ */
+class LockProfile
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a profile and register it under a name.
+     *
+     * @param name The name of the lock.
+     */
+    explicit LockProfile(LockName name);
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    LockProfile(const LockProfile& other) = delete;
+    LockProfile& operator=(const LockProfile& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    LockProfile(LockProfile&& other) = delete;
+    LockProfile& operator=(LockProfile&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the profile, keeping what it recorded under its name.
+     */
+    ~LockProfile();
+
+    /**
+     * @brief Lock a lock and record how long it took.
+     *
+     * @param lock The lock, which must not own its mutex.
+     *
+     * @return When the lock was acquired.
+     */
+    Clock::time_point acquire(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief Record that a lock was acquired elsewhere, such as together with
+     * other locks.
+     *
+     * @param start When acquiring the lock started.
+     *
+     * @param contended Whether the lock had to wait.
+     *
+     * @return When the lock was acquired.
+     */
+    Clock::time_point adopt(Clock::time_point start, bool contended);
+
+    /**
+     * @brief Record how long a lock was held.
+     *
+     * @details This must be called before the lock is unlocked.
+     *
+     * @param acquiredAt When the lock was acquired.
+     */
+    void release(Clock::time_point acquiredAt);
+
+    /**
+     * @brief Get the name of the lock.
+     *
+     * @return The name.
+     */
+    [[nodiscard]] const std::string& getName() const;
+
+    /**
+     * @brief Add what has been recorded to stats.
+     *
+     * @param stats The stats.
+     */
+    void addTo(LockStats& stats) const;
+
+private:
+    std::string m_name;
+    std::atomic_uint64_t m_contendedCount = 0;
+    Histogram m_wait;
+    Histogram m_hold;
+};
+}
+
+}
@@ -15,6 +15,10 @@ namespace chat::common
  *
  * @details The stream is used to build a buffer which usually contains objects
  * that have been serialized into bytes.
+ *
+ * A size that depends on what is written after it, such as the size of a frame,
+ * can be written in the same pass by reserving space for it first and filling
+ * it in afterwards, rather than building the rest in a separate stream.
  */
 class OutputByteStream
 {
@@ -24,6 +28,16 @@ public:
      */
     OutputByteStream() = default;
 
+    /**
+     * @brief Construct an output byte stream with room for some bytes.
+     *
+     * @details The stream only allocates again if more bytes than that are
+     * written.
+     *
+     * @param capacity The number of bytes to make room for.
+     */
+    explicit OutputByteStream(std::size_t capacity);
+
     /**
      * @brief Copy operations are disabled.
      * @{
@@ -59,6 +73,40 @@ public:
      */
     [[nodiscard]] const Buffer& getData() const;
 
+    /**
+     * @brief Move the data the stream has built out of the stream.
+     *
+     * @details The stream is empty afterwards.
+     *
+     * @return The data the stream has built.
+     */
+    [[nodiscard]] Buffer takeData();
+
+    /**
+     * @brief Reserve space for a size, as a @c std::uint32_t, that is filled in
+     * later with @c patchLength().
+     *
+     * @return The position of the size in the stream.
+     */
+    [[nodiscard]] std::size_t reserveLength();
+
+    /**
+     * @brief Fill in a reserved size with the number of bytes written after
+     * it.
+     *
+     * @details The size is in network byte order (big-endian), like a
+     * @c std::uint32_t inserted into the stream.
+     *
+     * @param position The position of the size, from @c reserveLength().
+     *
+     * @throws std::invalid_argument The position isn't followed by room for a
+     * size.
+     *
+     * @throws std::length_error The number of bytes doesn't fit in a
+     * @c std::uint32_t.
+     */
+    void patchLength(std::size_t position);
+
 private:
     Buffer m_buffer;
 };
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace chat::common
+{
+
+namespace detail
+{
+/**
+ * @brief Get the reader slot that the current thread tries first.
+ *
+ * @details Threads are handed out slots in turn, so threads that read at the
+ * same time usually start at different slots.
+ *
+ * @param slotCount The number of slots.
+ *
+ * @return The index of the slot.
+ */
+inline std::size_t getPreferredRcuSlot(std::size_t slotCount)
+{
+    static std::atomic_size_t nextSlot = 0;
+    thread_local const std::size_t slot =
+        nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot % slotCount;
+}
+}
+
+/**
+ * @brief Synchronize an object that is read on every request and replaced
+ * occasionally, in the style of read-copy-update.
+ *
+ * @details The object is never modified in place. A writer publishes a new
+ * version of it, and a reader pins whichever version is current, which stays
+ * valid and unchanged for as long as the reader holds it, even if newer
+ * versions are published in the meantime.
+ *
+ * A reader pins a version by putting it in a reader slot, which is on a cache
+ * line of its own, and checking that the version is still current. Readers on
+ * different threads use different slots, so reads don't write to any shared
+ * cache line and scale with the number of cores. Only if every slot is in use
+ * does a reader fall back to a shared counter.
+ *
+ * A replaced version is retired rather than destroyed. Retired versions are
+ * destroyed by the next writer, or by @c reclaim(), once no reader slot holds
+ * them and no reader is using the fallback counter. Writers are serialized by a
+ * mutex.
+ *
+ * @tparam T The type of the object to synchronize.
+ */
+template<typename T>
+class RcuSynced
+{
+public:
+    /**
+     * @brief Construct a synchronized object.
+     *
+     * @tparam Args The types of the arguments.
+     *
+     * @param args The arguments used to construct the first version of the
+     * object.
+     */
+    template<typename... Args>
+    explicit RcuSynced(Args&&... args)
+      : m_current{new T(std::forward<Args>(args)...)}
+    {}
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    RcuSynced(const RcuSynced& other) = delete;
+    RcuSynced& operator=(const RcuSynced& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    RcuSynced(RcuSynced&& other) = delete;
+    RcuSynced& operator=(RcuSynced&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the synchronized object.
+     *
+     * @details No reader may still hold a version.
+     */
+    ~RcuSynced()
+    {
+        delete m_current.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Provides read-only access to a pinned version of the object.
+     */
+    class Snapshot
+    {
+    public:
+        /**
+         * @brief Copy operations are disabled.
+         * @{
+         */
+        Snapshot(const Snapshot& other) = delete;
+        Snapshot& operator=(const Snapshot& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Move operations are disabled.
+         * @{
+         */
+        Snapshot(Snapshot&& other) = delete;
+        Snapshot& operator=(Snapshot&& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Destroy the snapshot, unpinning its version.
+         */
+        ~Snapshot()
+        {
+            if(m_slot != nullptr) {
+                m_slot->value.store(nullptr, std::memory_order_release);
+            } else {
+                m_synced.m_fallbackReaderCount.fetch_sub(
+                    1, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief Get the pinned version of the object.
+         *
+         * @details This can only be called when the snapshot is an lvalue to
+         * prevent obtaining a reference to the version after it's unpinned.
+         *
+         * @return The pinned version of the object.
+         */
+        [[nodiscard]] const T& get() &
+        {
+            return *m_value;
+        }
+
+        /**
+         * @brief Get the pinned version of the object.
+         *
+         * @details This can only be called when the snapshot is an lvalue to
+         * prevent obtaining a reference to the version after it's unpinned.
+         *
+         * @return The pinned version of the object.
+         */
+        [[nodiscard]] const T* operator->() &
+        {
+            return m_value;
+        }
+
+        /**
+         * @brief Get the pinned version of the object.
+         *
+         * @details This can only be called when the snapshot is an lvalue to
+         * prevent obtaining a reference to the version after it's unpinned.
+         *
+         * @return The pinned version of the object.
+         */
+        [[nodiscard]] const T& operator*() &
+        {
+            return *m_value;
+        }
+
+    private:
+        friend class RcuSynced;
+
+        /**
+         * @brief Construct a snapshot.
+         *
+         * @param synced The synchronized object creating the snapshot.
+         */
+        explicit Snapshot(const RcuSynced& synced)
+          : m_synced{synced},
+            m_slot{nullptr},
+            m_value{nullptr}
+        {
+            const std::size_t preferred =
+                detail::getPreferredRcuSlot(slotCount);
+            for(std::size_t i = 0; i < slotCount; i++) {
+                auto& slot = synced.m_slots.at((preferred + i) % slotCount);
+                const T* value = synced.m_current.load();
+                const T* expected = nullptr;
+                if(slot.value.compare_exchange_strong(expected, value)) {
+                    m_slot = &slot;
+                    m_value = synced.pinInSlot(slot, value);
+                    return;
+                }
+            }
+
+            // A writer doesn't reclaim anything while the counter is raised,
+            // so the version can be loaded after raising it
+            synced.m_fallbackReaderCount.fetch_add(1);
+            m_value = synced.m_current.load();
+        }
+
+        const RcuSynced& m_synced;
+        typename RcuSynced::Slot* m_slot;
+        const T* m_value;
+    };
+
+    /**
+     * @brief Pin the current version of the object.
+     *
+     * @return A snapshot that provides read-only access to the version.
+     */
+    [[nodiscard]] Snapshot read() const
+    {
+        return Snapshot{*this};
+    }
+
+    /**
+     * @brief Publish a new version of the object.
+     *
+     * @details Readers that pin the object afterwards get the new version.
+     * Readers holding older versions keep them until they're done.
+     *
+     * @param value The new version.
+     */
+    void publish(T value)
+    {
+        const std::lock_guard lock{m_writeMutex};
+        publishLocked(std::make_unique<T>(std::move(value)));
+    }
+
+    /**
+     * @brief Publish a modified copy of the current version of the object.
+     *
+     * @details The function runs while other writers are blocked, so updates
+     * that happen at the same time don't lose each other's changes.
+     *
+     * @tparam Function The type of the function.
+     *
+     * @param function The function, which is called with a reference to a copy
+     * of the current version to modify.
+     */
+    template<typename Function>
+    void update(Function&& function)
+    {
+        const std::lock_guard lock{m_writeMutex};
+        auto value =
+            std::make_unique<T>(*m_current.load(std::memory_order_relaxed));
+        function(*value);
+        publishLocked(std::move(value));
+    }
+
+    /**
+     * @brief Destroy the retired versions that no reader holds anymore.
+     *
+     * @details Writers already do this when they publish, so this is only
+     * needed to free memory sooner when no more versions are published.
+     */
+    void reclaim()
+    {
+        const std::lock_guard lock{m_writeMutex};
+        reclaimLocked();
+    }
+
+    /**
+     * @brief Get the number of replaced versions that haven't been destroyed.
+     *
+     * @return The number of retired versions.
+     */
+    [[nodiscard]] std::size_t getRetiredCount() const
+    {
+        const std::lock_guard lock{m_writeMutex};
+        return m_retired.size();
+    }
+
+private:
+    // More readers than this at the same time share the fallback counter
+    static constexpr std::size_t slotCount = 128;
+
+    // Keeps the slots on separate cache lines
+    static constexpr std::size_t cacheLineSize = 64;
+
+    /**
+     * @brief A place for a reader to pin a version, on its own cache line.
+     */
+    struct alignas(cacheLineSize) Slot
+    {
+        std::atomic<const T*> value = nullptr;
+    };
+
+    /**
+     * @brief Pin the current version in a slot that a reader has claimed.
+     *
+     * @details A writer might replace the version between loading it and
+     * putting it in the slot, so the version is only pinned once it's still
+     * current after being put in the slot.
+     *
+     * @param slot The slot, which holds @p value.
+     * @param value The version that was put in the slot.
+     *
+     * @return The pinned version.
+     */
+    const T* pinInSlot(Slot& slot, const T* value) const
+    {
+        while(true) {
+            const T* current = m_current.load();
+            if(current == value) {
+                return value;
+            }
+
+            slot.value.store(current);
+            value = current;
+        }
+    }
+
+    /**
+     * @brief Replace the current version and reclaim what can be reclaimed.
+     *
+     * @details The write mutex must be held.
+     *
+     * @param value The new version.
+     */
+    void publishLocked(std::unique_ptr<T> value)
+    {
+        const T* old = m_current.exchange(value.release());
+        m_retired.emplace_back(old);
+        reclaimLocked();
+    }
+
+    /**
+     * @brief Destroy the retired versions that no reader holds anymore.
+     *
+     * @details The write mutex must be held.
+     */
+    void reclaimLocked()
+    {
+        if(m_retired.empty() || m_fallbackReaderCount.load() != 0) {
+            return;
+        }
+
+        std::vector<const T*> pinned;
+        for(const auto& slot : m_slots) {
+            if(const T* value = slot.value.load()) {
+                pinned.push_back(value);
+            }
+        }
+
+        std::erase_if(m_retired, [&](const auto& retired) {
+            return std::ranges::find(pinned, retired.get()) == pinned.end();
+        });
+    }
+
+    std::atomic<const T*> m_current;
+    mutable std::array<Slot, slotCount> m_slots{};
+    mutable std::atomic_size_t m_fallbackReaderCount = 0;
+    mutable std::mutex m_writeMutex;
+    std::vector<std::unique_ptr<const T>> m_retired;
+};
+
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace chat::common
+{
+
+/**
+ * @brief Synchronize a small value that is read much more often than it's
+ * written, without readers locking.
+ *
+ * @details This is a sequence lock. A writer makes the sequence number odd,
+ * writes the value, and makes the sequence number even again. A reader copies
+ * the value between two reads of the sequence number and retries if a write
+ * was in progress or happened in between. Readers never write to shared memory,
+ * so any number of them can read at the same time without contending for a
+ * cache line, and they never block a writer. A reader only retries while a
+ * write overlaps its copy.
+ *
+ * Writers are serialized by a mutex.
+ *
+ * The value is copied in and out rather than referenced, so it must be
+ * trivially copyable and should be small. It's stored as atomic words so that
+ * a copy racing with a write is well-defined, even though it's thrown away.
+ *
+ * @tparam T The type of the value.
+ */
+template<typename T>
+    requires std::is_trivially_copyable_v<T> &&
+             std::is_default_constructible_v<T>
+class SeqSynced
+{
+public:
+    /**
+     * @brief Construct a synchronized value.
+     *
+     * @param value The initial value.
+     */
+    explicit SeqSynced(const T& value = T{})
+    {
+        storeWords(value);
+    }
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    SeqSynced(const SeqSynced& other) = delete;
+    SeqSynced& operator=(const SeqSynced& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    SeqSynced(SeqSynced&& other) = delete;
+    SeqSynced& operator=(SeqSynced&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the synchronized value.
+     */
+    ~SeqSynced() = default;
+
+    /**
+     * @brief Read the value.
+     *
+     * @return A copy of the value.
+     */
+    [[nodiscard]] T load() const
+    {
+        while(true) {
+            const auto before = m_sequence.load(std::memory_order_acquire);
+            if((before & 1U) != 0) {
+                continue;
+            }
+
+            const T value = loadWords();
+
+            // The fence keeps the copy from being reordered after the second
+            // read of the sequence number
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(m_sequence.load(std::memory_order_relaxed) == before) {
+                return value;
+            }
+        }
+    }
+
+    /**
+     * @brief Write the value.
+     *
+     * @param value The new value.
+     */
+    void store(const T& value)
+    {
+        const std::lock_guard lock{m_writeMutex};
+        write(value);
+    }
+
+    /**
+     * @brief Modify the value.
+     *
+     * @details The function runs while other writers are blocked, so updates
+     * that happen at the same time don't lose each other's changes. Readers
+     * keep reading the old value until the new one is written.
+     *
+     * @tparam Function The type of the function.
+     *
+     * @param function The function, which is called with a reference to a copy
+     * of the value to modify.
+     */
+    template<typename Function>
+    void update(Function&& function)
+    {
+        const std::lock_guard lock{m_writeMutex};
+        T value = loadWords();
+        function(value);
+        write(value);
+    }
+
+private:
+    static constexpr std::size_t wordCount =
+        (sizeof(T) + sizeof(std::uintptr_t) - 1) / sizeof(std::uintptr_t);
+    using Words = std::array<std::uintptr_t, wordCount>;
+
+    /**
+     * @brief Write the value between making the sequence number odd and even
+     * again.
+     *
+     * @details The write mutex must be held.
+     *
+     * @param value The new value.
+     */
+    void write(const T& value)
+    {
+        const auto sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+
+        // The fence keeps the words from being written before the sequence
+        // number is odd
+        std::atomic_thread_fence(std::memory_order_release);
+        storeWords(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy a value into the words.
+     *
+     * @param value The value.
+     */
+    void storeWords(const T& value)
+    {
+        Words words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for(std::size_t i = 0; i < wordCount; i++) {
+            m_words.at(i).store(words.at(i), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Copy the words into a value.
+     *
+     * @return The value.
+     */
+    [[nodiscard]] T loadWords() const
+    {
+        Words words{};
+        for(std::size_t i = 0; i < wordCount; i++) {
+            words.at(i) = m_words.at(i).load(std::memory_order_relaxed);
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+    std::atomic_uint64_t m_sequence{0};
+    std::array<std::atomic<std::uintptr_t>, wordCount> m_words{};
+    std::mutex m_writeMutex;
+};
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "chat/common/Buffer.hpp"
+
+#include <memory>
+
+namespace chat::common
+{
+
+/**
+ * @brief An immutable buffer whose ownership is shared.
+ *
+ * @details Useful for when bytes must outlive the code that created them
+ * without being copied, such as a frame waiting to be sent.
+ */
+using SharedBuffer = std::shared_ptr<const Buffer>;
+
+}
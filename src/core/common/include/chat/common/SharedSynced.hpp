@@ -0,0 +1,299 @@
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+namespace chat::common
+{
+
+/**
+ * @brief Synchronize an object that is read much more often than it's written.
+ *
+ * @details Like @c Synced, the object is only exposed once its mutex has been
+ * locked. Unlike @c Synced, the mutex is a `std::shared_mutex`, and reading
+ * the object only takes the mutex in shared mode, so any number of readers can
+ * hold the object at the same time. Writers still get exclusive access.
+ *
+ * Taking the mutex in shared mode still writes to the mutex, so readers on
+ * different cores contend for its cache line. This is cheaper than exclusive
+ * locking when the object is held for a while, but not when it's only held for
+ * a few instructions.
+ *
+ * @tparam T The type of the object to synchronize.
+ */
+template<typename T>
+class SharedSynced
+{
+public:
+    /**
+     * @brief Construct a synchronized object.
+     *
+     * @tparam Args The types of the arguments.
+     *
+     * @param args The arguments used to construct the object.
+     */
+    template<typename... Args>
+    explicit SharedSynced(Args&&... args)
+      : m_mutex{},
+        m_value{std::forward<Args>(args)...}
+    {}
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    SharedSynced(const SharedSynced& other) = delete;
+    SharedSynced& operator=(const SharedSynced& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    SharedSynced(SharedSynced&& other) = delete;
+    SharedSynced& operator=(SharedSynced&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the synchronized object.
+     */
+    ~SharedSynced() = default;
+
+    /**
+     * @brief Provides shared read-only access to the object.
+     */
+    class ConstProxy
+    {
+    public:
+        /**
+         * @brief Copy operations are disabled.
+         * @{
+         */
+        ConstProxy(const ConstProxy& other) = delete;
+        ConstProxy& operator=(const ConstProxy& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Move operations are disabled.
+         * @{
+         */
+        ConstProxy(ConstProxy&& other) = delete;
+        ConstProxy& operator=(ConstProxy&& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Destroy the proxy.
+         */
+        ~ConstProxy() = default;
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] const T& get() &
+        {
+            return *m_value;
+        }
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] const T* operator->() &
+        {
+            return m_value;
+        }
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] const T& operator*() &
+        {
+            return *m_value;
+        }
+
+        /**
+         * @brief Get the lock used on the mutex.
+         *
+         * @details This allows this type to be used with mechanisms like
+         * @c std::condition_variable_any.
+         *
+         * @return The locked used on the mutex.
+         */
+        [[nodiscard]] std::shared_lock<std::shared_mutex>& getLock()
+        {
+            return m_lock;
+        }
+
+    private:
+        friend class SharedSynced;
+
+        /**
+         * @brief Construct a proxy.
+         *
+         * @param synced The synchronized value creating the proxy.
+         */
+        explicit ConstProxy(const SharedSynced& synced)
+          : m_lock{synced.m_mutex},
+            m_value{&synced.m_value}
+        {}
+
+        std::shared_lock<std::shared_mutex> m_lock;
+        const T* m_value;
+    };
+
+    /**
+     * @brief Provides exclusive access to the object.
+     */
+    class Proxy
+    {
+    public:
+        /**
+         * @brief Copy operations are disabled.
+         * @{
+         */
+        Proxy(const Proxy& other) = delete;
+        Proxy& operator=(const Proxy& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Move operations are disabled.
+         * @{
+         */
+        Proxy(Proxy&& other) = delete;
+        Proxy& operator=(Proxy&& other) = delete;
+        /** @} */
+
+        /**
+         * @brief Destroy the proxy.
+         */
+        ~Proxy() = default;
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] T& get() &
+        {
+            return *m_value;
+        }
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] T* operator->() &
+        {
+            return m_value;
+        }
+
+        /**
+         * @brief Get the object being synchronized.
+         *
+         * @details This can only be called when the proxy is an lvalue to
+         * prevent obtaining a reference to the object while the mutex is
+         * unlocked.
+         *
+         * @return The object being synchronized.
+         */
+        [[nodiscard]] T& operator*() &
+        {
+            return *m_value;
+        }
+
+        /**
+         * @brief Get the lock used on the mutex.
+         *
+         * @details This allows this type to be used with mechanisms like
+         * @c std::condition_variable_any.
+         *
+         * @return The locked used on the mutex.
+         */
+        [[nodiscard]] std::unique_lock<std::shared_mutex>& getLock()
+        {
+            return m_lock;
+        }
+
+    private:
+        friend class SharedSynced;
+
+        /**
+         * @brief Construct a proxy.
+         *
+         * @param synced The synchronized value creating the proxy.
+         */
+        explicit Proxy(SharedSynced& synced)
+          : m_lock{synced.m_mutex},
+            m_value{&synced.m_value}
+        {}
+
+        std::unique_lock<std::shared_mutex> m_lock;
+        T* m_value;
+    };
+
+    /**
+     * @brief Get a proxy that provides shared read-only access to the object.
+     *
+     * @return A proxy that provides shared access to the object.
+     */
+    [[nodiscard]] ConstProxy lock() const
+    {
+        return ConstProxy{*this};
+    }
+
+    /**
+     * @brief Get a proxy that provides exclusive access to the object.
+     *
+     * @return A proxy that provides exclusive access to the object.
+     */
+    [[nodiscard]] Proxy lock()
+    {
+        return Proxy{*this};
+    }
+
+    /**
+     * @brief Get a proxy that provides shared read-only access to the object.
+     *
+     * @details Unlike @c lock(), this gives shared access through a non-`const`
+     * object too.
+     *
+     * @return A proxy that provides shared access to the object.
+     */
+    [[nodiscard]] ConstProxy lockShared() const
+    {
+        return ConstProxy{*this};
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    T m_value;
+};
+
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace chat::common
+{
+
+/**
+ * @brief A container that gives each of its objects a stable key.
+ *
+ * @details Objects are stored in slots of a vector. The key of an object holds
+ * the index of its slot and the generation of the slot, which is incremented
+ * every time an object is erased from the slot. Inserting, erasing, and finding
+ * an object by its key take constant time, and a key of an erased object never
+ * finds the object that reuses its slot, unless the generation of the slot
+ * wraps around after 2^32 reuses.
+ *
+ * The slots of erased objects are reused before the vector grows, so the
+ * memory used is proportional to the largest number of objects held at once.
+ *
+ * @tparam T The type of the objects.
+ */
+template<typename T>
+class SlotMap
+{
+public:
+    /**
+     * @brief The key of an object.
+     */
+    using Key = std::uint64_t;
+
+    /**
+     * @brief A key that never belongs to an object.
+     */
+    static constexpr Key nullKey = 0;
+
+    /**
+     * @brief Insert an object.
+     *
+     * @param value The object to insert.
+     *
+     * @return The key of the object.
+     */
+    Key insert(T value)
+    {
+        std::uint32_t index = 0;
+        if(m_freeIndices.empty()) {
+            index = static_cast<std::uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        } else {
+            index = m_freeIndices.back();
+            m_freeIndices.pop_back();
+        }
+
+        auto& slot = m_slots.at(index);
+        slot.value.emplace(std::move(value));
+        m_size++;
+        return makeKey(index, slot.generation);
+    }
+
+    /**
+     * @brief Erase an object.
+     *
+     * @param key The key of the object.
+     *
+     * @return True if the object was erased; false if there is no object with
+     * the key.
+     */
+    bool erase(Key key)
+    {
+        auto* slot = findSlot(key);
+        if(slot == nullptr) {
+            return false;
+        }
+
+        eraseSlot(*slot, getIndex(key));
+        return true;
+    }
+
+    /**
+     * @brief Find an object.
+     *
+     * @details The pointer is invalidated by the next insertion.
+     *
+     * @param key The key of the object.
+     *
+     * @return The object if there is an object with the key; otherwise,
+     * `nullptr`.
+     */
+    [[nodiscard]] T* find(Key key)
+    {
+        auto* slot = findSlot(key);
+        return slot != nullptr ? &slot->value.value() : nullptr;
+    }
+
+    /**
+     * @brief Find an object.
+     *
+     * @details The pointer is invalidated by the next insertion.
+     *
+     * @param key The key of the object.
+     *
+     * @return The object if there is an object with the key; otherwise,
+     * `nullptr`.
+     */
+    [[nodiscard]] const T* find(Key key) const
+    {
+        const auto* slot = findSlot(key);
+        return slot != nullptr ? &slot->value.value() : nullptr;
+    }
+
+    /**
+     * @brief Call a function on every object.
+     *
+     * @details The objects are visited in the order of their slots, which
+     * isn't necessarily the order they were inserted in. The function must not
+     * insert or erase objects.
+     *
+     * @tparam Function The type of the function.
+     *
+     * @param function The function to call with the key of the object and the
+     * object.
+     */
+    template<typename Function>
+    void forEach(Function&& function)
+    {
+        for(std::size_t i = 0; i < m_slots.size(); i++) {
+            auto& slot = m_slots.at(i);
+            if(slot.value.has_value()) {
+                const auto index = static_cast<std::uint32_t>(i);
+                function(makeKey(index, slot.generation), slot.value.value());
+            }
+        }
+    }
+
+    /**
+     * @brief Erase all objects.
+     *
+     * @details The keys of the erased objects don't find any objects
+     * afterwards.
+     */
+    void clear()
+    {
+        for(std::size_t i = 0; i < m_slots.size(); i++) {
+            auto& slot = m_slots.at(i);
+            if(slot.value.has_value()) {
+                eraseSlot(slot, static_cast<std::uint32_t>(i));
+            }
+        }
+    }
+
+    /**
+     * @brief Get the number of objects.
+     *
+     * @return The number of objects.
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Check if there are no objects.
+     *
+     * @return True if there are no objects; otherwise, false.
+     */
+    [[nodiscard]] bool empty() const
+    {
+        return m_size == 0;
+    }
+
+private:
+    /**
+     * @brief A place for an object.
+     */
+    struct Slot
+    {
+        std::optional<T> value;
+        std::uint32_t generation = 1;
+    };
+
+    /**
+     * @brief Create a key.
+     *
+     * @param index The index of the slot.
+     * @param generation The generation of the slot.
+     *
+     * @return The key.
+     */
+    static Key makeKey(std::uint32_t index, std::uint32_t generation)
+    {
+        return (static_cast<Key>(generation) << 32U) | index;
+    }
+
+    /**
+     * @brief Get the index of the slot from a key.
+     *
+     * @param key The key.
+     *
+     * @return The index of the slot.
+     */
+    static std::uint32_t getIndex(Key key)
+    {
+        return static_cast<std::uint32_t>(key);
+    }
+
+    /**
+     * @brief Get the generation of the slot from a key.
+     *
+     * @param key The key.
+     *
+     * @return The generation of the slot.
+     */
+    static std::uint32_t getGeneration(Key key)
+    {
+        return static_cast<std::uint32_t>(key >> 32U);
+    }
+
+    /**
+     * @brief Find the slot of an object.
+     *
+     * @param key The key of the object.
+     *
+     * @return The slot if there is an object with the key; otherwise,
+     * `nullptr`.
+     */
+    Slot* findSlot(Key key)
+    {
+        // The slots aren't `const`, so casting away the `const` is safe
+        return const_cast<Slot*>(std::as_const(*this).findSlot(key));
+    }
+
+    /**
+     * @brief Find the slot of an object.
+     *
+     * @param key The key of the object.
+     *
+     * @return The slot if there is an object with the key; otherwise,
+     * `nullptr`.
+     */
+    const Slot* findSlot(Key key) const
+    {
+        const std::uint32_t index = getIndex(key);
+        if(index >= m_slots.size()) {
+            return nullptr;
+        }
+
+        const auto& slot = m_slots.at(index);
+        if(!slot.value.has_value() || slot.generation != getGeneration(key)) {
+            return nullptr;
+        }
+
+        return &slot;
+    }
+
+    /**
+     * @brief Erase the object in a slot.
+     *
+     * @param slot The slot, which must have an object.
+     * @param index The index of the slot.
+     */
+    void eraseSlot(Slot& slot, std::uint32_t index)
+    {
+        slot.value.reset();
+
+        // The generation skips 0 when it wraps around so that no key is equal
+        // to the null key
+        slot.generation++;
+        if(slot.generation == 0) {
+            slot.generation = 1;
+        }
+
+        m_freeIndices.push_back(index);
+        m_size--;
+    }
+
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_freeIndices;
+    std::size_t m_size = 0;
+};
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "chat/common/Job.hpp"
+#include "chat/common/Synced.hpp"
+#include "chat/common/ThreadPool.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+
+namespace chat::common
+{
+
+/**
+ * @brief Runs jobs on a thread pool one at a time, in the order they are
+ * queued.
+ *
+ * @details Jobs queued into a thread pool can run at the same time on different
+ * threads. A strand serializes the jobs queued into it, so state only touched
+ * by the strand's jobs doesn't need to be synchronized. Different strands on
+ * the same thread pool still run at the same time.
+ *
+ * A strand only occupies the thread pool while it has jobs. The first job
+ * queued into an idle strand queues a runner into the thread pool, and the
+ * runner runs the strand's jobs back-to-back on the same thread rather than
+ * passing each one through the thread pool's queue. So that a busy strand
+ * doesn't hold onto a thread forever, the runner queues itself back into the
+ * thread pool after running a bounded number of jobs.
+ *
+ * Jobs that are still queued when the strand is destroyed are still run.
+ *
+ * The runner is queued into the thread pool with the priority of the strand,
+ * so a strand whose jobs only dispatch work can keep up while the thread pool
+ * has a backlog of bulk work.
+ */
+class Strand
+{
+public:
+    /**
+     * @brief Construct a strand.
+     *
+     * @param threadPool The thread pool to run jobs on.
+     * @param priority The priority to run jobs with.
+     */
+    explicit Strand(
+        ThreadPool& threadPool,
+        ThreadPool::Priority priority = ThreadPool::Priority::Normal);
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    Strand(const Strand& other) = delete;
+    Strand& operator=(const Strand& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    Strand(Strand&& other) = delete;
+    Strand& operator=(Strand&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the strand.
+     */
+    ~Strand() = default;
+
+    /**
+     * @brief Add a job to the strand.
+     *
+     * @details The job runs after every job queued before it has finished.
+     *
+     * @param job A function to run on a thread of the thread pool.
+     */
+    void queue(Job job);
+
+private:
+    /**
+     * @brief The jobs waiting to run.
+     *
+     * @details The flag indicating whether a runner is queued or running is
+     * kept with the jobs so that both are updated under the same lock.
+     */
+    struct Jobs
+    {
+        std::deque<Job> queued;
+        bool running = false;
+    };
+
+    /**
+     * @brief The state shared between the strand and its runner.
+     *
+     * @details The runner keeps the state alive, so the strand can be destroyed
+     * while the runner is still queued in the thread pool.
+     */
+    struct State
+    {
+        State(ThreadPool& threadPool, ThreadPool::Priority priority);
+
+        ThreadPool& threadPool;
+        ThreadPool::Priority priority;
+        Synced<Jobs> jobs;
+    };
+
+    /**
+     * @brief Run the queued jobs of a strand.
+     *
+     * @details Batches of jobs are taken from the queue and run until the
+     * queue is empty. A batch never holds more jobs than the runner has left
+     * to run, and once the maximum number of jobs has been run, the runner is
+     * queued back into the thread pool with the rest of the jobs still queued.
+     *
+     * @param state The state of the strand.
+     */
+    static void run(const std::shared_ptr<State>& state);
+
+    // The number of jobs a runner runs before giving its thread back to the
+    // thread pool
+    static constexpr std::size_t maxRunCount = 64;
+
+    std::shared_ptr<State> m_state;
+};
+
+}
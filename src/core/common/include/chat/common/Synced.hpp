@@ -1,10 +1,96 @@
 #pragma once
 
+#include "chat/common/LockProfiling.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace chat::common
 {
 
+template<typename T>
+class Synced;
+
+namespace detail
+{
+class SyncedLocker;
+
+/**
+ * @brief The mutex of a synchronized object, locked on behalf of a proxy.
+ *
+ * @details Only the functions that lock several synchronized objects at once,
+ * such as @c lockAll(), can create this, so a proxy can't adopt a mutex that
+ * isn't locked.
+ *
+ * @tparam S The type of the synchronized object, which is `const` for a
+ * read-only proxy.
+ */
+template<typename S>
+class AdoptedLock
+{
+public:
+    /**
+     * @brief Get the synchronized object.
+     *
+     * @return The synchronized object.
+     */
+    [[nodiscard]] S& getSynced() const
+    {
+        return *m_synced;
+    }
+
+    /**
+     * @brief Get when locking the mutex started.
+     *
+     * @return When locking started.
+     */
+    [[nodiscard]] LockProfile::Clock::time_point getStart() const
+    {
+        return m_start;
+    }
+
+    /**
+     * @brief Check if the mutex had to wait to be locked.
+     *
+     * @return True if the mutex had to wait, otherwise false.
+     */
+    [[nodiscard]] bool isContended() const
+    {
+        return m_contended;
+    }
+
+private:
+    friend class SyncedLocker;
+
+    /**
+     * @brief Construct an adopted lock.
+     *
+     * @param synced The synchronized object, whose mutex is locked.
+     *
+     * @param start When locking the mutex started.
+     *
+     * @param contended Whether the mutex had to wait to be locked.
+     */
+    AdoptedLock(S& synced, LockProfile::Clock::time_point start,
+                bool contended)
+      : m_synced{&synced},
+        m_start{start},
+        m_contended{contended}
+    {}
+
+    S* m_synced;
+    LockProfile::Clock::time_point m_start;
+    bool m_contended;
+};
+}
+
 /**
  * @brief Syncrhonize an object throughout its lifetime.
  *
@@ -13,6 +99,11 @@ namespace chat::common
  * the object can be used without locking the mutex. This class aims to prevent
  * such errors by only exposing the object once the mutex has been locked.
  *
+ * A synchronized object can be given a name. When locks are profiled (see
+ * @c isLockProfilingEnabled), how long each lock of a named object waited for
+ * the mutex and how long it held the mutex are recorded under that name. Time
+ * spent with the mutex unlocked through @c getLock() counts as held.
+ *
  * @tparam T The type of the object to synchronize.
  */
 template<typename T>
@@ -32,6 +123,25 @@ public:
         m_value{std::forward<Args>(args)...}
     {}
 
+    /**
+     * @brief Construct a named synchronized object.
+     *
+     * @tparam Args The types of the arguments.
+     *
+     * @param name The name the object's locks are profiled under.
+     *
+     * @param args The arguments used to construct the object.
+     */
+    template<typename... Args>
+    explicit Synced([[maybe_unused]] LockName name, Args&&... args)
+      : m_mutex{},
+        m_value{std::forward<Args>(args)...}
+    {
+#if defined(CHAT_LOCK_PROFILING)
+        m_profile = std::make_unique<detail::LockProfile>(name);
+#endif
+    }
+
     /**
      * @brief Copy operations are disabled.
      * @{
@@ -81,7 +191,14 @@ public:
         /**
          * @brief Destroy the proxy.
          */
-        ~ConstProxy() = default;
+        ~ConstProxy()
+        {
+#if defined(CHAT_LOCK_PROFILING)
+            if(m_profile != nullptr) {
+                m_profile->release(m_acquiredAt);
+            }
+#endif
+        }
 
         /**
          * @brief Get the object being synchronized.
@@ -138,6 +255,27 @@ public:
             return m_lock;
         }
 
+        /**
+         * @brief Construct a proxy for a mutex that's already locked.
+         *
+         * @details This lets @c lockAll() and similar functions return proxies.
+         *
+         * @param adopted The locked mutex.
+         */
+#if defined(CHAT_LOCK_PROFILING)
+        explicit ConstProxy(detail::AdoptedLock<const Synced> adopted)
+          : m_lock{adopted.getSynced().m_mutex, std::adopt_lock},
+            m_value{&adopted.getSynced().m_value},
+            m_profile{adopted.getSynced().m_profile.get()},
+            m_acquiredAt{adopted.getSynced().adopt(adopted)}
+        {}
+#else
+        explicit ConstProxy(detail::AdoptedLock<const Synced> adopted)
+          : m_lock{adopted.getSynced().m_mutex, std::adopt_lock},
+            m_value{&adopted.getSynced().m_value}
+        {}
+#endif
+
     private:
         friend class Synced;
 
@@ -146,13 +284,26 @@ public:
          *
          * @param synced The synchronized value creating the proxy.
          */
+#if defined(CHAT_LOCK_PROFILING)
+        explicit ConstProxy(const Synced& synced)
+          : m_lock{synced.m_mutex, std::defer_lock},
+            m_value{&synced.m_value},
+            m_profile{synced.m_profile.get()},
+            m_acquiredAt{synced.acquire(m_lock)}
+        {}
+#else
         explicit ConstProxy(const Synced& synced)
           : m_lock{synced.m_mutex},
             m_value{&synced.m_value}
         {}
+#endif
 
         std::unique_lock<std::mutex> m_lock;
         const T* m_value;
+#if defined(CHAT_LOCK_PROFILING)
+        detail::LockProfile* m_profile;
+        detail::LockProfile::Clock::time_point m_acquiredAt;
+#endif
     };
 
     /**
@@ -183,7 +334,14 @@ public:
         /**
          * @brief Destroy the proxy.
          */
-        ~Proxy() = default;
+        ~Proxy()
+        {
+#if defined(CHAT_LOCK_PROFILING)
+            if(m_profile != nullptr) {
+                m_profile->release(m_acquiredAt);
+            }
+#endif
+        }
 
         /**
          * @brief Get the object being synchronized.
@@ -240,6 +398,27 @@ public:
             return m_lock;
         }
 
+        /**
+         * @brief Construct a proxy for a mutex that's already locked.
+         *
+         * @details This lets @c lockAll() and similar functions return proxies.
+         *
+         * @param adopted The locked mutex.
+         */
+#if defined(CHAT_LOCK_PROFILING)
+        explicit Proxy(detail::AdoptedLock<Synced> adopted)
+          : m_lock{adopted.getSynced().m_mutex, std::adopt_lock},
+            m_value{&adopted.getSynced().m_value},
+            m_profile{adopted.getSynced().m_profile.get()},
+            m_acquiredAt{adopted.getSynced().adopt(adopted)}
+        {}
+#else
+        explicit Proxy(detail::AdoptedLock<Synced> adopted)
+          : m_lock{adopted.getSynced().m_mutex, std::adopt_lock},
+            m_value{&adopted.getSynced().m_value}
+        {}
+#endif
+
     private:
         friend class Synced;
 
@@ -248,13 +427,26 @@ public:
          *
          * @param synced The synchronized value creating the proxy.
          */
+#if defined(CHAT_LOCK_PROFILING)
+        explicit Proxy(Synced& synced)
+          : m_lock{synced.m_mutex, std::defer_lock},
+            m_value{&synced.m_value},
+            m_profile{synced.m_profile.get()},
+            m_acquiredAt{synced.acquire(m_lock)}
+        {}
+#else
         explicit Proxy(Synced& synced)
           : m_lock{synced.m_mutex},
             m_value{&synced.m_value}
         {}
+#endif
 
         std::unique_lock<std::mutex> m_lock;
         T* m_value;
+#if defined(CHAT_LOCK_PROFILING)
+        detail::LockProfile* m_profile;
+        detail::LockProfile::Clock::time_point m_acquiredAt;
+#endif
     };
 
     /**
@@ -278,8 +470,287 @@ public:
     }
 
 private:
+    friend class detail::SyncedLocker;
+
+#if defined(CHAT_LOCK_PROFILING)
+    /**
+     * @brief Record that the mutex was locked together with other mutexes, if
+     * the object is named.
+     *
+     * @tparam S The type of the synchronized object.
+     *
+     * @param adopted The locked mutex.
+     *
+     * @return When the mutex was locked.
+     */
+    template<typename S>
+    detail::LockProfile::Clock::time_point adopt(
+        const detail::AdoptedLock<S>& adopted) const
+    {
+        if(m_profile == nullptr) {
+            return {};
+        }
+
+        return m_profile->adopt(adopted.getStart(), adopted.isContended());
+    }
+
+    /**
+     * @brief Lock the mutex, recording how long it took if the object is
+     * named.
+     *
+     * @param lock The lock, which must not own the mutex.
+     *
+     * @return When the mutex was locked.
+     */
+    detail::LockProfile::Clock::time_point acquire(
+        std::unique_lock<std::mutex>& lock) const
+    {
+        if(m_profile == nullptr) {
+            lock.lock();
+            return {};
+        }
+
+        return m_profile->acquire(lock);
+    }
+#endif
+
     mutable std::mutex m_mutex;
     T m_value;
+#if defined(CHAT_LOCK_PROFILING)
+    std::unique_ptr<detail::LockProfile> m_profile;
+#endif
 };
 
+namespace detail
+{
+/**
+ * @brief Check if a type is a synchronized object, `const` or not.
+ *
+ * @tparam S The type.
+ */
+template<typename S>
+struct IsSynced : std::false_type
+{};
+
+template<typename T>
+struct IsSynced<Synced<T>> : std::true_type
+{};
+
+template<typename T>
+struct IsSynced<const Synced<T>> : std::true_type
+{};
+
+/**
+ * @brief Locks the mutexes of several synchronized objects at once.
+ */
+class SyncedLocker
+{
+public:
+    using Clock = LockProfile::Clock;
+
+    /**
+     * @brief The proxies of several synchronized objects.
+     *
+     * @tparam S The types of the synchronized objects.
+     */
+    template<typename... S>
+    using Proxies = std::tuple<decltype(std::declval<S&>().lock())...>;
+
+    /**
+     * @brief Lock the mutexes of synchronized objects.
+     *
+     * @tparam S The types of the synchronized objects.
+     *
+     * @param synced The synchronized objects.
+     *
+     * @return The proxies.
+     */
+    template<typename... S>
+    [[nodiscard]] static Proxies<S...> lockAll(S&... synced)
+    {
+        const auto start = getStart();
+        if(tryLockMutexes(synced.m_mutex...)) {
+            return Proxies<S...>{AdoptedLock<S>{synced, start, false}...};
+        }
+
+        if constexpr(sizeof...(S) == 1) {
+            (synced.m_mutex.lock(), ...);
+        } else {
+            std::lock(synced.m_mutex...);
+        }
+        return Proxies<S...>{AdoptedLock<S>{synced, start, true}...};
+    }
+
+    /**
+     * @brief Lock the mutexes of synchronized objects if none of them are
+     * locked.
+     *
+     * @tparam S The types of the synchronized objects.
+     *
+     * @param synced The synchronized objects.
+     *
+     * @return The proxies, or nothing if a mutex was locked.
+     */
+    template<typename... S>
+    [[nodiscard]] static std::optional<Proxies<S...>> tryLock(S&... synced)
+    {
+        const auto start = getStart();
+        if(!tryLockMutexes(synced.m_mutex...)) {
+            return std::nullopt;
+        }
+
+        return std::optional<Proxies<S...>>{
+            std::in_place, AdoptedLock<S>{synced, start, false}...};
+    }
+
+    /**
+     * @brief Lock the mutexes of synchronized objects, giving up after a
+     * while.
+     *
+     * @details A @c std::mutex can't wait with a timeout, so this retries
+     * locking every mutex at once, sleeping for longer between each attempt.
+     *
+     * @tparam S The types of the synchronized objects.
+     *
+     * @param timeout How long to try for.
+     *
+     * @param synced The synchronized objects.
+     *
+     * @return The proxies, or nothing if the mutexes couldn't all be locked in
+     * time.
+     */
+    template<typename... S>
+    [[nodiscard]] static std::optional<Proxies<S...>> tryLockFor(
+        Clock::duration timeout, S&... synced)
+    {
+        const auto start = Clock::now();
+        const auto deadline = start + timeout;
+        Clock::duration backoff = minBackoff;
+        for(bool contended = false;; contended = true) {
+            if(tryLockMutexes(synced.m_mutex...)) {
+                return std::optional<Proxies<S...>>{
+                    std::in_place, AdoptedLock<S>{synced, start, contended}...};
+            }
+
+            const auto now = Clock::now();
+            if(now >= deadline) {
+                return std::nullopt;
+            }
+
+            std::this_thread::sleep_for(std::min(backoff, deadline - now));
+            backoff = std::min<Clock::duration>(backoff * 2, maxBackoff);
+        }
+    }
+
+private:
+    static constexpr std::chrono::microseconds minBackoff{1};
+    static constexpr std::chrono::milliseconds maxBackoff{1};
+
+    /**
+     * @brief Get when locking started, which is only needed for profiling.
+     *
+     * @return The current time if locks are profiled, otherwise nothing.
+     */
+    [[nodiscard]] static Clock::time_point getStart()
+    {
+        if constexpr(isLockProfilingEnabled) {
+            return Clock::now();
+        } else {
+            return {};
+        }
+    }
+
+    /**
+     * @brief Lock every mutex if none of them are locked.
+     *
+     * @tparam Mutexes The types of the mutexes.
+     *
+     * @param mutexes The mutexes.
+     *
+     * @return True if every mutex was locked, otherwise false and none of them
+     * are locked.
+     */
+    template<typename... Mutexes>
+    [[nodiscard]] static bool tryLockMutexes(Mutexes&... mutexes)
+    {
+        if constexpr(sizeof...(Mutexes) == 1) {
+            return (mutexes.try_lock() && ...);
+        } else {
+            return std::try_lock(mutexes...) == -1;
+        }
+    }
+};
+}
+
+/**
+ * @brief Lock several synchronized objects at once without deadlocking.
+ *
+ * @details Like @c std::scoped_lock, the mutexes are locked with a deadlock
+ * avoidance algorithm, so threads locking the same objects in different orders
+ * don't deadlock. An object may only be passed once.
+ *
+ * @tparam S The types of the synchronized objects, which get read-only proxies
+ * if they're `const`.
+ *
+ * @param synced The synchronized objects.
+ *
+ * @return A tuple with a proxy for each object, in the same order.
+ */
+template<typename... S>
+    requires(sizeof...(S) > 0 && (detail::IsSynced<S>::value && ...))
+[[nodiscard]] detail::SyncedLocker::Proxies<S...> lockAll(S&... synced)
+{
+    return detail::SyncedLocker::lockAll(synced...);
+}
+
+/**
+ * @brief Lock several synchronized objects at once if none of them are locked.
+ *
+ * @details This doesn't block. An object may only be passed once.
+ *
+ * @tparam S The types of the synchronized objects, which get read-only proxies
+ * if they're `const`.
+ *
+ * @param synced The synchronized objects.
+ *
+ * @return A tuple with a proxy for each object, in the same order, or nothing
+ * if an object was locked.
+ */
+template<typename... S>
+    requires(sizeof...(S) > 0 && (detail::IsSynced<S>::value && ...))
+[[nodiscard]] std::optional<detail::SyncedLocker::Proxies<S...>> tryLock(
+    S&... synced)
+{
+    return detail::SyncedLocker::tryLock(synced...);
+}
+
+/**
+ * @brief Lock several synchronized objects at once, giving up after a while.
+ *
+ * @details An object may only be passed once.
+ *
+ * @tparam Rep The type of the number of ticks of the timeout.
+ *
+ * @tparam Period The period of the ticks of the timeout.
+ *
+ * @tparam S The types of the synchronized objects, which get read-only proxies
+ * if they're `const`.
+ *
+ * @param timeout How long to try for.
+ *
+ * @param synced The synchronized objects.
+ *
+ * @return A tuple with a proxy for each object, in the same order, or nothing
+ * if the objects couldn't all be locked in time.
+ */
+template<typename Rep, typename Period, typename... S>
+    requires(sizeof...(S) > 0 && (detail::IsSynced<S>::value && ...))
+[[nodiscard]] std::optional<detail::SyncedLocker::Proxies<S...>> tryLockFor(
+    std::chrono::duration<Rep, Period> timeout, S&... synced)
+{
+    return detail::SyncedLocker::tryLockFor(
+        std::chrono::ceil<detail::SyncedLocker::Clock::duration>(timeout),
+        synced...);
+}
+
 }
@@ -1,11 +1,24 @@
 #pragma once
 
+#include "chat/common/Histogram.hpp"
+#include "chat/common/Job.hpp"
+#include "chat/common/Synced.hpp"
+#include "chat/common/TimingWheel.hpp"
+#include "chat/common/WorkStealingDeque.hpp"
+#include "chat/common/affinity.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
+#include <deque>
+#include <latch>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <span>
 #include <thread>
 #include <vector>
 
@@ -14,16 +27,303 @@ namespace chat::common
 
 /**
  * @brief A pool of threads waiting to run jobs.
+ *
+ * @details Each thread owns a work-stealing deque of jobs. A job queued by one
+ * of the pool's threads, such as a job that queues follow-up work, is pushed
+ * onto that thread's deque without locking. A job queued by any other thread
+ * goes into a shared injection queue, which threads take jobs from in batches
+ * once their own deque is empty. A thread that finds no jobs in either place
+ * steals the oldest job of another thread before going to sleep, so a burst of
+ * jobs queued on one thread is spread over the whole pool.
+ *
+ * Threads only take the mutex of the pool to sleep, to be woken, and to take
+ * jobs from the injection queue.
+ *
+ * Jobs are kept in tasks that are recycled once their job has run. Each thread
+ * keeps the tasks it frees for the jobs it queues and hands its surplus to the
+ * injection queue for the jobs queued by other threads, so queueing a job
+ * doesn't allocate once the pool has warmed up.
+ *
+ * Jobs that are created together, such as the requests of a single receive,
+ * can be queued as a batch, which takes the locks and wakes the sleeping
+ * threads once for the whole batch rather than once per job.
+ *
+ * Every job is queued with a priority, and each priority has its own lane in
+ * the deques and the injection queue. Threads look for high priority jobs
+ * before normal priority ones, so a job that measures liveness doesn't wait
+ * behind a backlog of bulk work. So that a steady stream of high priority jobs
+ * can't starve the normal priority ones, a thread that has run many high
+ * priority jobs in a row looks for a normal priority job first.
+ *
+ * A thread that runs out of jobs waits for more according to the pool's idle
+ * policy. It can spin and then yield for a while before going to sleep, which
+ * trades CPU time for not having to be woken by the thread that queues the
+ * next job.
+ *
+ * A coroutine can move itself onto the pool by awaiting @c schedule(), which
+ * queues the resumption of the coroutine as a job. The coroutine's frame holds
+ * its state across the hop, so a multi-step task doesn't need a callback and a
+ * captured copy of its state per step.
+ *
+ * Jobs can also be queued to run after a delay or repeatedly. Their timers are
+ * kept in a timing wheel that's driven by a separate timer thread, which queues
+ * each job into the pool once its timer expires. Adding and cancelling a timer
+ * take constant time, so every connection can have its own timers without a
+ * timer object and a wait operation each. Timers are counted in ticks of
+ * @c timerTick, and a job never runs before its delay has passed.
+ *
+ * The pool either has a fixed number of threads or is elastic. An elastic pool
+ * starts a thread, up to its maximum, whenever a job has waited longer than
+ * the target to be started while no thread was sleeping, and a thread that has
+ * slept for the idle timeout exits while there are more than the minimum. The
+ * wait is measured when a job is started, and the timer thread also checks for
+ * jobs that are waiting while no job has been started, so a pool whose threads
+ * are all stuck in long jobs still grows. Every thread's deque is created up
+ * front, so threads that exit and start again don't move jobs.
+ *
+ * Each thread records how long its jobs waited to be started and how long they
+ * ran in histograms of its own, along with counts of its steals, idle periods
+ * and exceptions, so recording takes no locks and no contended atomics. The
+ * statistics of all threads are merged when they're read.
  */
 class ThreadPool
 {
 public:
+    /**
+     * @brief The priority of a job.
+     */
+    enum class Priority : std::uint8_t
+    {
+        /**
+         * @brief For short jobs that must not wait behind other work, such as
+         * control messages.
+         */
+        High,
+
+        /**
+         * @brief For all other jobs.
+         */
+        Normal,
+    };
+
+    /**
+     * @brief How a thread waits for jobs once it has run out of them.
+     *
+     * @details A thread first spins, checking for jobs between short pauses of
+     * the CPU, then yields its time slice between checks, and finally sleeps
+     * until it's woken. Waking a sleeping thread costs the thread that queues a
+     * job a system call and costs the job the scheduler's latency, which
+     * spinning and yielding avoid at the cost of CPU time.
+     */
+    struct IdlePolicy
+    {
+        /**
+         * @brief Get the policy that sleeps as soon as there are no jobs.
+         *
+         * @return The policy.
+         */
+        [[nodiscard]] static constexpr IdlePolicy powerSaving()
+        {
+            return IdlePolicy{.spinCount = 0, .yieldCount = 0};
+        }
+
+        /**
+         * @brief Get the policy that keeps checking for jobs for a while
+         * before sleeping.
+         *
+         * @return The policy.
+         */
+        [[nodiscard]] static constexpr IdlePolicy lowLatency()
+        {
+            constexpr std::size_t spinCount = 4096;
+            constexpr std::size_t yieldCount = 64;
+            return IdlePolicy{.spinCount = spinCount, .yieldCount = yieldCount};
+        }
+
+        /**
+         * @brief The number of times to check for jobs while spinning.
+         */
+        std::size_t spinCount = 0;
+
+        /**
+         * @brief The number of times to check for jobs while yielding, after
+         * spinning.
+         */
+        std::size_t yieldCount = 0;
+    };
+
+    /**
+     * @brief The clock used for delayed and repeating jobs.
+     */
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The ID of a delayed or repeating job, used to cancel it.
+     */
+    using TimerId = std::uint64_t;
+
+    /**
+     * @brief The resolution of delayed and repeating jobs.
+     */
+    static constexpr std::chrono::milliseconds timerTick{1};
+
+    /**
+     * @brief How many threads the pool has.
+     */
+    struct SizingPolicy
+    {
+        /**
+         * @brief Get the policy of a fixed number of threads.
+         *
+         * @param threadCount The number of threads.
+         *
+         * @return The policy.
+         */
+        [[nodiscard]] static constexpr SizingPolicy fixed(
+            std::size_t threadCount)
+        {
+            return SizingPolicy{.minThreadCount = threadCount,
+                                .maxThreadCount = threadCount};
+        }
+
+        /**
+         * @brief The number of threads the pool starts with and never goes
+         * below.
+         */
+        std::size_t minThreadCount = 0;
+
+        /**
+         * @brief The number of threads the pool never goes above.
+         *
+         * @details The pool is elastic if this is greater than the minimum.
+         */
+        std::size_t maxThreadCount = 0;
+
+        /**
+         * @brief The longest a job should wait to be started before another
+         * thread is started.
+         *
+         * @details This is also the least time between starting threads, so a
+         * burst of waiting jobs doesn't start every thread at once.
+         */
+        Clock::duration targetQueueWait = std::chrono::milliseconds{10};
+
+        /**
+         * @brief The time a thread sleeps for before it exits.
+         */
+        Clock::duration idleTimeout = std::chrono::seconds{30};
+    };
+
+    /**
+     * @brief A snapshot of the statistics of a pool.
+     *
+     * @details The statistics of each thread are read on their own, so they
+     * might not all be from the same instant.
+     */
+    struct Stats
+    {
+        /**
+         * @brief The time from queueing a job to starting it, in nanoseconds.
+         */
+        Histogram::Snapshot queueWait;
+
+        /**
+         * @brief The time a job ran for, in nanoseconds.
+         */
+        Histogram::Snapshot runTime;
+
+        /**
+         * @brief The most jobs that have been waiting to be started at once.
+         */
+        std::size_t maxQueuedCount = 0;
+
+        /**
+         * @brief The number of jobs a thread took from the deque of another
+         * thread.
+         */
+        std::uint64_t stealCount = 0;
+
+        /**
+         * @brief The number of times a thread ran out of jobs.
+         */
+        std::uint64_t idleCount = 0;
+
+        /**
+         * @brief The number of jobs that threw an exception.
+         */
+        std::uint64_t exceptionCount = 0;
+    };
+
+    /**
+     * @brief An awaitable that resumes the awaiting coroutine on one of the
+     * pool's threads.
+     */
+    class ScheduleAwaitable
+    {
+    public:
+        /**
+         * @brief Construct an awaitable.
+         *
+         * @param pool The pool to resume the coroutine on.
+         * @param priority The priority of the job that resumes the coroutine.
+         */
+        ScheduleAwaitable(ThreadPool& pool, Priority priority)
+          : m_pool{pool},
+            m_priority{priority}
+        {}
+
+        /**
+         * @brief Check if the coroutine can continue without suspending.
+         *
+         * @return False, since the coroutine always has to move to the pool.
+         */
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        /**
+         * @brief Queue a job that resumes the suspended coroutine.
+         *
+         * @param coroutine The suspended coroutine.
+         */
+        void await_suspend(std::coroutine_handle<> coroutine);
+
+        /**
+         * @brief Continue the coroutine once it's resumed.
+         */
+        void await_resume() const noexcept {}
+
+    private:
+        ThreadPool& m_pool;
+        Priority m_priority;
+    };
+
     /**
      * @brief Construct a thread pool.
      *
      * @param threadCount The number of threads the pool will have.
+     * @param idlePolicy How threads wait for jobs once they've run out.
+     * @param cpus The CPUs the threads may run on, or an empty set to let them
+     * run on any CPU.
+     */
+    explicit ThreadPool(std::size_t threadCount,
+                        IdlePolicy idlePolicy = IdlePolicy::powerSaving(),
+                        affinity::CpuSet cpus = {});
+
+    /**
+     * @brief Construct a thread pool that may be elastic.
+     *
+     * @param sizing How many threads the pool has. The minimum must not be
+     * greater than the maximum, and an elastic pool must have at least 1
+     * thread.
+     * @param idlePolicy How threads wait for jobs once they've run out.
+     * @param cpus The CPUs the threads may run on, or an empty set to let them
+     * run on any CPU.
      */
-    explicit ThreadPool(std::size_t threadCount);
+    explicit ThreadPool(SizingPolicy sizing,
+                        IdlePolicy idlePolicy = IdlePolicy::powerSaving(),
+                        affinity::CpuSet cpus = {});
 
     /**
      * @brief Copy operations are disabled.
@@ -50,8 +350,108 @@ public:
      * @brief Add a job to the queue.
      *
      * @param job A function to run on a thread.
+     * @param priority The priority of the job.
+     */
+    void queue(Job job, Priority priority = Priority::Normal);
+
+    /**
+     * @brief Add a batch of jobs to the queue.
+     *
+     * @details The jobs are moved out of the span. At most one sleeping thread
+     * is woken per job.
+     *
+     * @param jobs The functions to run on threads.
+     * @param priority The priority of the jobs.
      */
-    void queue(std::function<void()> job);
+    void queue(std::span<Job> jobs, Priority priority = Priority::Normal);
+
+    /**
+     * @brief Add a batch of jobs to the queue and count each one down on a
+     * latch once it has finished.
+     *
+     * @details The jobs are moved out of the span. At most one sleeping thread
+     * is woken per job.
+     *
+     * @param jobs The functions to run on threads.
+     * @param latch The latch to count down. It must outlive the jobs.
+     * @param priority The priority of the jobs.
+     */
+    void queue(std::span<Job> jobs, std::latch& latch,
+               Priority priority = Priority::Normal);
+
+    /**
+     * @brief Run a batch of jobs and block until they have all finished.
+     *
+     * @details Unlike @c waitForCompletion(), this doesn't wait for any other
+     * jobs. When called from one of the pool's threads, the thread runs jobs
+     * while it waits rather than blocking, so that waiting threads can't take
+     * up the whole pool.
+     *
+     * @param jobs The functions to run on threads. They're moved out of the
+     * span.
+     * @param priority The priority of the jobs.
+     */
+    void run(std::span<Job> jobs, Priority priority = Priority::Normal);
+
+    /**
+     * @brief Add a job to the queue once a delay has passed.
+     *
+     * @details The job isn't counted by @c waitForCompletion() until it's
+     * queued.
+     *
+     * @param delay The time to wait before queueing the job.
+     * @param job A function to run on a thread.
+     * @param priority The priority of the job.
+     *
+     * @return The ID of the job, which can be used to cancel it.
+     */
+    TimerId queueAfter(Clock::duration delay, Job job,
+                       Priority priority = Priority::Normal);
+
+    /**
+     * @brief Add a job to the queue every time a period has passed.
+     *
+     * @details The job first runs one period after it's added. A run never
+     * starts before the previous run has finished, and the runs that are missed
+     * while a run takes longer than the period are skipped rather than run
+     * back-to-back. The job runs until it's cancelled.
+     *
+     * @param period The time between the starts of the runs.
+     * @param job A function to run on a thread.
+     * @param priority The priority of the job.
+     *
+     * @return The ID of the job, which can be used to cancel it.
+     */
+    TimerId queueEvery(Clock::duration period, Job job,
+                       Priority priority = Priority::Normal);
+
+    /**
+     * @brief Cancel a delayed or repeating job.
+     *
+     * @details A delayed job that has already been queued can't be cancelled. A
+     * repeating job that's running finishes its run, but isn't run again.
+     *
+     * @param timer The ID of the job.
+     *
+     * @return True if the job was cancelled; false if it has already been
+     * queued or cancelled.
+     */
+    bool cancel(TimerId timer);
+
+    /**
+     * @brief Move the awaiting coroutine onto one of the pool's threads.
+     *
+     * @details `co_await pool.schedule()` suspends the coroutine and queues a
+     * job that resumes it, so the rest of the coroutine runs on the pool until
+     * it's suspended again. If the pool is destroyed before the job runs, the
+     * coroutine is destroyed instead of resumed.
+     *
+     * @param priority The priority of the job that resumes the coroutine.
+     *
+     * @return The awaitable.
+     */
+    [[nodiscard]] ScheduleAwaitable schedule(
+        Priority priority = Priority::Normal);
 
     /**
      * @brief Prevent all threads from starting jobs.
@@ -73,27 +473,489 @@ public:
      */
     void waitForCompletion();
 
+    /**
+     * @brief Get the number of jobs of a priority waiting to be started.
+     *
+     * @details The count is only a snapshot since other threads can queue and
+     * start jobs at the same time.
+     *
+     * @param priority The priority of the jobs.
+     *
+     * @return The number of jobs waiting to be started.
+     */
+    [[nodiscard]] std::size_t getQueuedCount(Priority priority) const;
+
+    /**
+     * @brief Get the number of threads that are running.
+     *
+     * @return The number of threads.
+     */
+    [[nodiscard]] std::size_t getThreadCount() const;
+
+    /**
+     * @brief Get the number of threads an elastic pool has started because
+     * jobs were waiting, not counting the threads it started with.
+     *
+     * @return The number of threads started.
+     */
+    [[nodiscard]] std::uint64_t getThreadStartCount() const;
+
+    /**
+     * @brief Get the number of threads an elastic pool has stopped because
+     * they were idle.
+     *
+     * @return The number of threads stopped.
+     */
+    [[nodiscard]] std::uint64_t getThreadRetireCount() const;
+
+    /**
+     * @brief Get a snapshot of the statistics of the pool.
+     *
+     * @return The statistics.
+     */
+    [[nodiscard]] Stats getStats() const;
+
 private:
+    static constexpr std::size_t priorityCount = 2;
+
+    /**
+     * @brief A queued job.
+     */
+    struct Task
+    {
+        /**
+         * @brief The job to run.
+         */
+        Job job;
+
+        /**
+         * @brief The latch to count down once the job has finished, if any.
+         */
+        std::latch* latch = nullptr;
+
+        /**
+         * @brief The priority of the job.
+         */
+        Priority priority = Priority::Normal;
+
+        /**
+         * @brief The time the job was queued at.
+         */
+        Clock::time_point queuedAt;
+    };
+
+    /**
+     * @brief A delayed or repeating job.
+     */
+    struct Timer
+    {
+        /**
+         * @brief The job to queue, which is empty while a repeating job is
+         * running.
+         */
+        Job job;
+
+        /**
+         * @brief The priority of the job.
+         */
+        Priority priority = Priority::Normal;
+
+        /**
+         * @brief The tick the job is queued at.
+         */
+        std::uint64_t tick = 0;
+
+        /**
+         * @brief The number of ticks between the runs of a repeating job, or 0
+         * for a delayed job.
+         */
+        std::uint64_t period = 0;
+    };
+
+    /**
+     * @brief A queue of tasks for each priority.
+     */
+    template<typename Queue>
+    using Lanes = std::array<Queue, priorityCount>;
+
+    /**
+     * @brief The state of a thread.
+     */
+    struct Worker
+    {
+        /**
+         * @brief The index of the worker in the pool.
+         */
+        std::size_t index = 0;
+
+        /**
+         * @brief The tasks queued by the thread.
+         *
+         * @details The deques own the tasks they hold.
+         */
+        Lanes<WorkStealingDeque<Task*>> tasks;
+
+        /**
+         * @brief The number of high priority tasks the thread has run since
+         * it last ran a normal priority task.
+         */
+        std::size_t highPriorityStreak = 0;
+
+        /**
+         * @brief The tasks freed by the thread.
+         */
+        std::vector<std::unique_ptr<Task>> freeTasks;
+
+        /**
+         * @brief Whether the thread is running.
+         *
+         * @details This is guarded by the mutex of the pool. A thread that has
+         * exited stays joinable until it's started again or the pool is
+         * destroyed.
+         */
+        bool active = false;
+
+        /**
+         * @brief The number of jobs the thread has started.
+         *
+         * @details Only the thread writes this, and the timer thread reads it
+         * to find out if jobs are being started at all.
+         */
+        std::atomic_uint64_t startedCount = 0;
+
+        /**
+         * @brief The statistics of the thread, which only the thread writes.
+         * @{
+         */
+        Histogram queueWait;
+        Histogram runTime;
+        std::atomic_uint64_t stealCount = 0;
+        std::atomic_uint64_t idleCount = 0;
+        std::atomic_uint64_t exceptionCount = 0;
+        /** @} */
+
+        /**
+         * @brief The thread.
+         */
+        std::thread thread;
+    };
+
     /**
      * @brief The function the threads run.
      *
-     * @details This function runs jobs from the queue when available. This
-     * function stops when the thread pool is being destroyed. This function
-     * pauses execution when the thread pool is paused even if there are jobs
-     * available. This function notifies anyone calling @c waitForCompletion()
-     * when there are no more jobs available and all threads are idle.
+     * @details This function runs jobs when available. This function stops
+     * when the thread pool is being destroyed. This function pauses execution
+     * when the thread pool is paused even if there are jobs available. This
+     * function notifies anyone calling @c waitForCompletion() when there are
+     * no more jobs available and all threads are idle.
+     *
+     * @param index The index of the thread's worker.
+     */
+    void threadLoop(std::size_t index);
+
+    /**
+     * @brief The function the timer thread runs.
+     *
+     * @details This function sleeps until the next timer may expire and queues
+     * the jobs of the expired timers. This function stops when the thread pool
+     * is being destroyed.
+     */
+    void timerLoop();
+
+    /**
+     * @brief Add a timer.
+     *
+     * @param delay The time until the job is first queued.
+     * @param period The number of ticks between the runs of a repeating job, or
+     * 0 for a delayed job.
+     * @param job The job.
+     * @param priority The priority of the job.
+     *
+     * @return The ID of the timer.
+     */
+    TimerId addTimer(Clock::duration delay, std::uint64_t period, Job job,
+                     Priority priority);
+
+    /**
+     * @brief Run a repeating job and schedule its next run.
+     *
+     * @details The job is moved out of its timer while it runs, so cancelling
+     * the timer during the run doesn't destroy the running job.
+     *
+     * @param timer The ID of the timer.
+     */
+    void runRepeatingJob(TimerId timer);
+
+    /**
+     * @brief Wake the timer thread if it's sleeping past a tick.
+     *
+     * @details The timer mutex must be held.
+     *
+     * @param tick The tick a timer was scheduled at.
+     */
+    void notifyTimer(std::uint64_t tick);
+
+    /**
+     * @brief Get the number of whole ticks from the start of the timers to a
+     * time.
+     *
+     * @param time The time.
+     *
+     * @return The number of ticks.
+     */
+    [[nodiscard]] std::uint64_t getTimerTick(Clock::time_point time) const;
+
+    /**
+     * @brief Queue a batch of jobs.
+     *
+     * @param jobs The jobs, which are moved out of the span.
+     * @param latch The latch to count down once each job has finished, if any.
+     * @param priority The priority of the jobs.
+     */
+    void queueTasks(std::span<Job> jobs, std::latch* latch, Priority priority);
+
+    /**
+     * @brief Find a job for a thread and run it.
+     *
+     * @param worker The thread's worker.
+     *
+     * @return True if a job was run; false if no job was found or the thread
+     * pool is paused.
+     */
+    [[nodiscard]] bool runTask(Worker& worker);
+
+    /**
+     * @brief Find a task for a thread to run.
+     *
+     * @details The high priority lanes are checked before the normal priority
+     * lanes, unless the thread has run too many high priority tasks in a row.
+     *
+     * @param worker The thread's worker.
+     *
+     * @return The task if one was found; otherwise, `nullptr`.
+     */
+    [[nodiscard]] std::unique_ptr<Task> findTask(Worker& worker);
+
+    /**
+     * @brief Find a task of a priority for a thread to run.
+     *
+     * @details The thread's own deque is checked first, then the injection
+     * queue, and then the deques of the other threads.
+     *
+     * @param worker The thread's worker.
+     * @param priority The priority of the task.
+     *
+     * @return The task if one was found; otherwise, `nullptr`.
+     */
+    [[nodiscard]] std::unique_ptr<Task> findTask(Worker& worker,
+                                                 Priority priority);
+
+    /**
+     * @brief Move a batch of tasks from the injection queue to a thread's
+     * deque.
+     *
+     * @param worker The thread's worker.
+     * @param priority The priority of the tasks.
+     *
+     * @return One of the tasks if the injection queue wasn't empty; otherwise,
+     * `nullptr`.
+     */
+    [[nodiscard]] std::unique_ptr<Task> takeInjectedTasks(Worker& worker,
+                                                          Priority priority);
+
+    /**
+     * @brief Steal a task from the other threads.
+     *
+     * @param worker The stealing thread's worker.
+     * @param priority The priority of the task.
+     *
+     * @return The task if one was stolen; otherwise, `nullptr`.
+     */
+    [[nodiscard]] std::unique_ptr<Task> stealTask(const Worker& worker,
+                                                  Priority priority);
+
+    /**
+     * @brief Check if there are queued jobs that haven't been started.
+     *
+     * @return True if there are queued jobs; otherwise, false.
+     */
+    [[nodiscard]] bool hasQueuedTasks() const;
+
+    /**
+     * @brief Spin and then yield until there are jobs a thread can run, as
+     * allowed by the idle policy.
+     *
+     * @return True if there are jobs the thread can run or the thread pool is
+     * being destroyed; false if the thread should sleep.
+     */
+    [[nodiscard]] bool spinForWork() const;
+
+    /**
+     * @brief Check if there are jobs that a thread can run.
+     *
+     * @return True if there are jobs the thread can run or the thread pool is
+     * being destroyed; otherwise, false.
+     */
+    [[nodiscard]] bool isWorkAvailable() const;
+
+    /**
+     * @brief Put a thread to sleep until there are jobs it can run.
+     *
+     * @details A thread of an elastic pool that sleeps for the idle timeout
+     * exits if the pool has more than its minimum number of threads.
+     *
+     * @param worker The thread's worker.
+     *
+     * @return True if the thread should keep running; false if the thread pool
+     * is being destroyed or the thread has exited.
+     */
+    [[nodiscard]] bool waitForWork(Worker& worker);
+
+    /**
+     * @brief Start the thread of a worker.
+     *
+     * @details The mutex of the pool must be held.
+     *
+     * @param worker The worker, which must not be active.
+     */
+    void startWorker(Worker& worker);
+
+    /**
+     * @brief Start another thread of an elastic pool if a job has waited too
+     * long to be started.
+     *
+     * @param wait The time the job has waited.
+     */
+    void growIfLagging(Clock::duration wait);
+
+    /**
+     * @brief Get the number of jobs the threads have started.
+     *
+     * @return The number of jobs started.
      */
-    void threadLoop();
+    [[nodiscard]] std::uint64_t getStartedCount() const;
 
-    std::size_t m_threadCount;
+    /**
+     * @brief Raise the high water mark of the number of queued jobs to the
+     * current number, if it's higher.
+     */
+    void updateMaxQueuedCount();
+
+    /**
+     * @brief Add one to a counter that only one thread writes.
+     *
+     * @param counter The counter.
+     */
+    static void increment(std::atomic_uint64_t& counter);
+
+    /**
+     * @brief Check if the pool is elastic.
+     *
+     * @return True if the pool is elastic; otherwise, false.
+     */
+    [[nodiscard]] bool isElastic() const;
+
+    /**
+     * @brief Take a free task.
+     *
+     * @param freeTasks The free tasks to take from.
+     *
+     * @return A free task, which is allocated if there are no free tasks.
+     */
+    [[nodiscard]] static std::unique_ptr<Task> takeFreeTask(
+        std::vector<std::unique_ptr<Task>>& freeTasks);
+
+    /**
+     * @brief Free a task that has run.
+     *
+     * @param worker The worker of the thread that ran the task.
+     * @param task The task, whose job must be empty.
+     */
+    void freeTask(Worker& worker, std::unique_ptr<Task> task);
+
+    /**
+     * @brief Wake sleeping threads, if any, to run newly queued jobs.
+     *
+     * @param jobCount The number of newly queued jobs.
+     */
+    void notifyWork(std::size_t jobCount);
+
+    /**
+     * @brief Mark a job as finished.
+     *
+     * @details Anyone calling @c waitForCompletion() is notified when this was
+     * the last job.
+     */
+    void finishJob();
+
+    // The most tasks a thread takes from the injection queue at once, which
+    // leaves the rest for other threads to take without stealing
+    static constexpr std::size_t maxInjectedBatchSize = 32;
+
+    // The most free tasks kept by a thread and by the injection queue
+    static constexpr std::size_t maxFreeTaskCount = 256;
+
+    // The most high priority tasks a thread runs in a row while there are
+    // normal priority tasks waiting
+    static constexpr std::size_t maxHighPriorityStreak = 16;
+
+    /**
+     * @brief The tasks queued by threads outside of the pool.
+     */
+    struct Injection
+    {
+        Lanes<std::deque<std::unique_ptr<Task>>> queued;
+        std::vector<std::unique_ptr<Task>> freeTasks;
+    };
+
+    SizingPolicy m_sizing;
+    IdlePolicy m_idlePolicy;
+    affinity::CpuSet m_cpus;
     std::mutex m_mutex;
-    bool m_stopping;
-    bool m_pause;
-    std::size_t m_idleCount;
+    std::atomic_bool m_stopping;
+    std::atomic_bool m_pause;
+
+    // The number of jobs of each priority that were queued but haven't been
+    // started
+    Lanes<std::atomic_size_t> m_queuedCounts;
+
+    // The most jobs that have been waiting to be started at once
+    std::atomic_size_t m_maxQueuedCount;
+
+    // The number of jobs that were queued but haven't finished
+    std::atomic_size_t m_pendingCount;
+
+    std::atomic_size_t m_sleepingCount;
+
+    // The number of threads that are running, and the number of threads that
+    // were started and stopped after construction
+    std::atomic_size_t m_threadCount;
+    std::atomic_uint64_t m_threadStartCount;
+    std::atomic_uint64_t m_threadRetireCount;
+
+    // The time a thread was last started because jobs were waiting, which is
+    // guarded by the mutex
+    Clock::time_point m_lastGrowth;
+
     std::condition_variable m_workCondvar;
     std::condition_variable m_idleCondvar;
-    std::vector<std::thread> m_threads;
-    std::queue<std::function<void()>> m_jobs;
+    Synced<Injection> m_injection;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    Clock::time_point m_timerStart;
+    std::mutex m_timerMutex;
+    std::condition_variable m_timerCondvar;
+    TimingWheel<Timer> m_timers;
+
+    // The tick the timer thread sleeps until, so that only a timer that
+    // expires before it has to wake the thread
+    std::uint64_t m_timerWakeTick;
+
+    // Whether the timer thread of an elastic pool sleeps without checking how
+    // long jobs wait, so that queueing a job has to wake it
+    std::atomic_bool m_timerWaitingForWork;
+
+    std::thread m_timerThread;
 };
 
 }
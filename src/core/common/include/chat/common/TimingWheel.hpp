@@ -0,0 +1,398 @@
+#pragma once
+
+#include "chat/common/SlotMap.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace chat::common
+{
+
+/**
+ * @brief A hierarchical timing wheel of timers that expire at a tick.
+ *
+ * @details Time is counted in ticks, and the wheel's current tick only moves
+ * forward when the wheel is advanced. Each level of the wheel has a slot per
+ * value of a group of bits of a tick, where the first level covers the lowest
+ * bits. A timer is put in the slot of the lowest level whose higher bits are
+ * the same for its tick and the current tick. When the current tick reaches a
+ * slot of a higher level, the timers in the slot are put in the lower levels,
+ * and the timers in the slot of the current tick in the first level expire.
+ *
+ * Timers are kept in a slot map, and each slot holds a doubly linked list of
+ * the keys of its timers, so inserting and erasing a timer take constant time
+ * no matter how many timers there are. A timer that's too far away for the top
+ * level waits in an overflow slot until the top level wraps around.
+ *
+ * An expired timer is removed from its slot but kept in the wheel, so its key
+ * stays valid until it's erased or rescheduled. This lets a repeating timer be
+ * rescheduled under the same key.
+ *
+ * @tparam T The type of the objects held by the timers.
+ */
+template<typename T>
+class TimingWheel
+{
+private:
+    struct Timer;
+
+public:
+    /**
+     * @brief The key of a timer.
+     */
+    using Key = typename SlotMap<Timer>::Key;
+
+    /**
+     * @brief A key that never belongs to a timer.
+     */
+    static constexpr Key nullKey = SlotMap<Timer>::nullKey;
+
+    /**
+     * @brief Construct a timing wheel.
+     *
+     * @param tick The current tick.
+     */
+    explicit TimingWheel(std::uint64_t tick = 0)
+      : m_tick{tick},
+        m_slots(slotCount * levelCount + 1, nullKey),
+        m_timers{}
+    {}
+
+    /**
+     * @brief Insert a timer.
+     *
+     * @details A timer for a tick that has already been reached expires on the
+     * next tick.
+     *
+     * @param tick The tick the timer expires at.
+     * @param value The object held by the timer.
+     *
+     * @return The key of the timer.
+     */
+    Key insert(std::uint64_t tick, T value)
+    {
+        const Key key = m_timers.insert(Timer{.value = std::move(value)});
+        link(key, tick, m_tick + 1);
+        return key;
+    }
+
+    /**
+     * @brief Erase a timer.
+     *
+     * @param key The key of the timer.
+     *
+     * @return True if the timer was erased; false if there is no timer with the
+     * key.
+     */
+    bool erase(Key key)
+    {
+        if(m_timers.find(key) == nullptr) {
+            return false;
+        }
+
+        unlink(key);
+        m_timers.erase(key);
+        return true;
+    }
+
+    /**
+     * @brief Set the tick a timer expires at.
+     *
+     * @details This works for both timers that are waiting and timers that have
+     * expired.
+     *
+     * @param key The key of the timer.
+     * @param tick The tick the timer expires at.
+     *
+     * @return True if the timer was rescheduled; false if there is no timer
+     * with the key.
+     */
+    bool reschedule(Key key, std::uint64_t tick)
+    {
+        if(m_timers.find(key) == nullptr) {
+            return false;
+        }
+
+        unlink(key);
+        link(key, tick, m_tick + 1);
+        return true;
+    }
+
+    /**
+     * @brief Find the object held by a timer.
+     *
+     * @details The pointer is invalidated by the next insertion.
+     *
+     * @param key The key of the timer.
+     *
+     * @return The object if there is a timer with the key; otherwise,
+     * `nullptr`.
+     */
+    [[nodiscard]] T* find(Key key)
+    {
+        auto* timer = m_timers.find(key);
+        return timer != nullptr ? &timer->value : nullptr;
+    }
+
+    /**
+     * @brief Move the current tick forward.
+     *
+     * @details The timers that expire are removed from their slots and their
+     * keys are appended to @p expired. They stay in the wheel until they're
+     * erased or rescheduled. Advancing takes time proportional to the number of
+     * ticks passed plus the number of timers moved or expired.
+     *
+     * @param tick The new current tick. Nothing happens if it isn't after the
+     * current tick.
+     * @param expired The keys of the timers that expired.
+     */
+    void advance(std::uint64_t tick, std::vector<Key>& expired)
+    {
+        while(m_tick < tick) {
+            m_tick++;
+
+            // Timers are moved down from the highest level first, so a timer
+            // can be moved down several levels on the same tick
+            if((m_tick & maxTick) == 0) {
+                relink(overflowSlot);
+            }
+            for(std::size_t level = levelCount - 1; level > 0; level--) {
+                if((m_tick & getLevelMask(level)) == 0) {
+                    relink(getSlot(level, m_tick));
+                }
+            }
+
+            const std::size_t slot = getSlot(0, m_tick);
+            while(m_slots.at(slot) != nullKey) {
+                const Key key = m_slots.at(slot);
+                unlink(key);
+                expired.push_back(key);
+            }
+        }
+    }
+
+    /**
+     * @brief Get the tick by which the wheel should next be advanced.
+     *
+     * @details This is the next tick a timer may expire at. It's never more
+     * than a turn of the first level away, since higher levels are only looked
+     * at when the first level wraps around.
+     *
+     * @return The tick if there are timers waiting; otherwise, nothing.
+     */
+    [[nodiscard]] std::optional<std::uint64_t> getNextTick() const
+    {
+        if(m_waitingCount == 0) {
+            return std::nullopt;
+        }
+
+        for(std::uint64_t tick = m_tick + 1; (tick & slotMask) != 0; tick++) {
+            if(m_slots.at(getSlot(0, tick)) != nullKey) {
+                return tick;
+            }
+        }
+
+        return (m_tick | slotMask) + 1;
+    }
+
+    /**
+     * @brief Get the current tick.
+     *
+     * @return The current tick.
+     */
+    [[nodiscard]] std::uint64_t getTick() const
+    {
+        return m_tick;
+    }
+
+    /**
+     * @brief Get the number of timers, including expired ones.
+     *
+     * @return The number of timers.
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_timers.size();
+    }
+
+    /**
+     * @brief Check if there are no timers.
+     *
+     * @return True if there are no timers; otherwise, false.
+     */
+    [[nodiscard]] bool empty() const
+    {
+        return m_timers.empty();
+    }
+
+private:
+    static constexpr std::size_t slotBits = 8;
+    static constexpr std::size_t slotCount = std::size_t{1} << slotBits;
+    static constexpr std::uint64_t slotMask = slotCount - 1;
+    static constexpr std::size_t levelCount = 4;
+
+    // The furthest tick the levels can hold relative to the start of their
+    // turn, which is about 49 days with 1 millisecond ticks
+    static constexpr std::uint64_t maxTick =
+        (std::uint64_t{1} << (slotBits * levelCount)) - 1;
+
+    static constexpr std::size_t overflowSlot = slotCount * levelCount;
+    static constexpr std::size_t noSlot =
+        std::numeric_limits<std::size_t>::max();
+
+    /**
+     * @brief A timer.
+     */
+    struct Timer
+    {
+        /**
+         * @brief The object held by the timer.
+         */
+        T value;
+
+        /**
+         * @brief The tick the timer expires at.
+         */
+        std::uint64_t tick = 0;
+
+        /**
+         * @brief The slot the timer is in, or @c noSlot if it has expired.
+         */
+        std::size_t slot = noSlot;
+
+        /**
+         * @brief The previous and next timers in the slot.
+         * @{
+         */
+        Key previous = nullKey;
+        Key next = nullKey;
+        /** @} */
+    };
+
+    /**
+     * @brief Get the mask of the bits of a tick below a level.
+     *
+     * @param level The level.
+     *
+     * @return The mask.
+     */
+    static constexpr std::uint64_t getLevelMask(std::size_t level)
+    {
+        return (std::uint64_t{1} << (slotBits * level)) - 1;
+    }
+
+    /**
+     * @brief Get the slot of a level that a tick falls in.
+     *
+     * @param level The level.
+     * @param tick The tick.
+     *
+     * @return The index of the slot.
+     */
+    static constexpr std::size_t getSlot(std::size_t level, std::uint64_t tick)
+    {
+        const auto index = (tick >> (slotBits * level)) & slotMask;
+        return (level * slotCount) + static_cast<std::size_t>(index);
+    }
+
+    /**
+     * @brief Put a timer that isn't in a slot into the slot of its tick.
+     *
+     * @param key The key of the timer.
+     * @param tick The tick the timer expires at.
+     * @param earliestTick The earliest tick the timer may expire at. A timer
+     * that's due before it expires at it rather than being lost behind the
+     * current tick.
+     */
+    void link(Key key, std::uint64_t tick, std::uint64_t earliestTick)
+    {
+        auto& timer = *m_timers.find(key);
+        timer.tick = tick;
+
+        const std::uint64_t target = std::max(tick, earliestTick);
+        timer.slot = overflowSlot;
+        for(std::size_t level = 0; level < levelCount; level++) {
+            const std::size_t higherBits = slotBits * (level + 1);
+            if((target >> higherBits) == (m_tick >> higherBits)) {
+                timer.slot = getSlot(level, target);
+                break;
+            }
+        }
+
+        auto& head = m_slots.at(timer.slot);
+        timer.previous = nullKey;
+        timer.next = head;
+        if(head != nullKey) {
+            m_timers.find(head)->previous = key;
+        }
+        head = key;
+        m_waitingCount++;
+    }
+
+    /**
+     * @brief Take a timer out of its slot, if it's in one.
+     *
+     * @param key The key of the timer.
+     */
+    void unlink(Key key)
+    {
+        auto& timer = *m_timers.find(key);
+        if(timer.slot == noSlot) {
+            return;
+        }
+
+        if(timer.previous != nullKey) {
+            m_timers.find(timer.previous)->next = timer.next;
+        } else {
+            m_slots.at(timer.slot) = timer.next;
+        }
+        if(timer.next != nullKey) {
+            m_timers.find(timer.next)->previous = timer.previous;
+        }
+
+        timer.slot = noSlot;
+        timer.previous = nullKey;
+        timer.next = nullKey;
+        m_waitingCount--;
+    }
+
+    /**
+     * @brief Put every timer of a slot back into the slot of its tick.
+     *
+     * @details This is done after the current tick has moved forward but
+     * before the timers of the current tick expire, so a timer that's due at
+     * the current tick can still expire on it.
+     *
+     * @param slot The index of the slot.
+     */
+    void relink(std::size_t slot)
+    {
+        Key key = std::exchange(m_slots.at(slot), nullKey);
+        while(key != nullKey) {
+            auto& timer = *m_timers.find(key);
+            const Key next = timer.next;
+            timer.slot = noSlot;
+            m_waitingCount--;
+            link(key, timer.tick, m_tick);
+            key = next;
+        }
+    }
+
+    std::uint64_t m_tick;
+
+    // The first key of each slot's list, with the levels one after another
+    // followed by the overflow slot
+    std::vector<Key> m_slots;
+
+    SlotMap<Timer> m_timers;
+
+    // The number of timers that are in a slot
+    std::size_t m_waitingCount = 0;
+};
+
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace chat::common
+{
+
+/**
+ * @brief A lock-free deque that one thread owns and other threads steal from.
+ *
+ * @details This is the Chase-Lev deque. The owner pushes and pops objects at
+ * the bottom of the deque, which makes the owner work through its objects in
+ * last-in-first-out order while they're still in its cache. Other threads steal
+ * objects from the top of the deque, which gives them the oldest objects. The
+ * owner only synchronizes with thieves when the deque is about to run empty, so
+ * pushing and popping are nearly as cheap as on a plain array.
+ *
+ * The objects are kept in a circular array that grows when it's full. The
+ * arrays that are grown out of are kept until the deque is destroyed, since a
+ * thief could still be reading from one of them.
+ *
+ * @tparam T The type of the objects. It must be trivially copyable since
+ * thieves read an object before they know if they won the race for it.
+ */
+template<typename T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Work-stealing deque objects must be trivially copyable");
+
+public:
+    /**
+     * @brief Construct a deque.
+     *
+     * @param capacity The minimum number of objects the deque can hold before
+     * growing. It's rounded up to the next power of 2.
+     */
+    explicit WorkStealingDeque(std::size_t capacity = defaultCapacity)
+      : m_top{0},
+        m_bottom{0},
+        m_array{nullptr},
+        m_arrays{}
+    {
+        m_arrays.emplace_back(std::make_unique<Array>(capacity));
+        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    WorkStealingDeque(WorkStealingDeque&& other) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the deque.
+     */
+    ~WorkStealingDeque() = default;
+
+    /**
+     * @brief Push an object onto the bottom of the deque.
+     *
+     * @details This must only be called by the owner.
+     *
+     * @param value The object to push.
+     */
+    void push(T value)
+    {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = m_top.load(std::memory_order_acquire);
+        Array* array = m_array.load(std::memory_order_relaxed);
+        if(bottom - top >= static_cast<std::int64_t>(array->getCapacity())) {
+            m_arrays.emplace_back(array->grow(top, bottom));
+            array = m_arrays.back().get();
+            m_array.store(array, std::memory_order_release);
+        }
+
+        array->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pop an object from the bottom of the deque.
+     *
+     * @details This must only be called by the owner.
+     *
+     * @return The object at the bottom of the deque, or nothing if the deque
+     * is empty.
+     */
+    [[nodiscard]] std::optional<T> pop()
+    {
+        const std::int64_t bottom =
+            m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if(top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        std::optional<T> value = array->get(bottom);
+        if(top == bottom) {
+            // The last object is also visible to thieves, so the owner has to
+            // race them for it
+            if(!m_top.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                value.reset();
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return value;
+    }
+
+    /**
+     * @brief Steal an object from the top of the deque.
+     *
+     * @details This can be called from any thread.
+     *
+     * @return The object at the top of the deque, or nothing if the deque is
+     * empty or another thread took the object first.
+     */
+    [[nodiscard]] std::optional<T> steal()
+    {
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if(top >= bottom) {
+            return std::nullopt;
+        }
+
+        const Array* array = m_array.load(std::memory_order_acquire);
+        T value = array->get(top);
+        if(!m_top.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * @brief Check if the deque is empty.
+     *
+     * @details This can be called from any thread. The result is only a
+     * snapshot since other threads can change the deque at the same time.
+     *
+     * @return True if the deque is empty; otherwise, false.
+     */
+    [[nodiscard]] bool empty() const
+    {
+        const std::int64_t top = m_top.load(std::memory_order_acquire);
+        const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        return top >= bottom;
+    }
+
+private:
+    static constexpr std::size_t defaultCapacity = 256;
+
+    // Keeps the position owned by the thieves and the position owned by the
+    // owner on separate cache lines
+    static constexpr std::size_t cacheLineSize = 64;
+
+    /**
+     * @brief A circular array of objects.
+     */
+    class Array
+    {
+    public:
+        /**
+         * @brief Construct an array.
+         *
+         * @param capacity The minimum number of objects the array can hold.
+         * It's rounded up to the next power of 2.
+         */
+        explicit Array(std::size_t capacity)
+          : m_mask{std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1},
+            m_values{std::make_unique<std::atomic<T>[]>(m_mask + 1)}
+        {}
+
+        /**
+         * @brief Get the number of objects the array can hold.
+         *
+         * @return The number of objects the array can hold.
+         */
+        [[nodiscard]] std::size_t getCapacity() const
+        {
+            return m_mask + 1;
+        }
+
+        /**
+         * @brief Get the object at a position.
+         *
+         * @param position The position of the object.
+         *
+         * @return The object.
+         */
+        [[nodiscard]] T get(std::int64_t position) const
+        {
+            return m_values[static_cast<std::size_t>(position) & m_mask].load(
+                std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Put an object at a position.
+         *
+         * @param position The position of the object.
+         * @param value The object.
+         */
+        void put(std::int64_t position, T value)
+        {
+            m_values[static_cast<std::size_t>(position) & m_mask].store(
+                value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Create an array twice as large with the same objects.
+         *
+         * @param top The position of the first object.
+         * @param bottom The position after the last object.
+         *
+         * @return The new array.
+         */
+        [[nodiscard]] std::unique_ptr<Array> grow(std::int64_t top,
+                                                  std::int64_t bottom) const
+        {
+            auto array = std::make_unique<Array>(getCapacity() * 2);
+            for(std::int64_t i = top; i < bottom; i++) {
+                array->put(i, get(i));
+            }
+
+            return array;
+        }
+
+    private:
+        std::size_t m_mask;
+        std::unique_ptr<std::atomic<T>[]> m_values;
+    };
+
+    alignas(cacheLineSize) std::atomic<std::int64_t> m_top;
+    alignas(cacheLineSize) std::atomic<std::int64_t> m_bottom;
+    std::atomic<Array*> m_array;
+
+    // Only used by the owner
+    std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace chat::common::affinity
+{
+/**
+ * @brief A set of CPUs, identified by their index in the system.
+ */
+using CpuSet = std::vector<std::size_t>;
+
+/**
+ * @brief Parse a list of CPUs.
+ *
+ * @details The list uses the same format as `taskset --cpu-list` and
+ * `/sys/devices/system/cpu/online`: comma-separated CPU indexes and inclusive
+ * ranges of CPU indexes, such as `0-3,8,10-11`.
+ *
+ * @param list The list to parse.
+ *
+ * @return The CPUs in the list, in the order they're listed, or nothing if the
+ * list is malformed or lists more CPUs than a system can have.
+ */
+[[nodiscard]] std::optional<CpuSet> parseCpuList(std::string_view list);
+
+/**
+ * @brief Restrict the current thread to run on a set of CPUs.
+ *
+ * @details Memory is placed on the NUMA node of the CPU that first touches it,
+ * so the memory a pinned thread allocates and initializes stays local to the
+ * thread. Pinning to an empty set has no effect.
+ *
+ * @param cpus The CPUs the thread may run on.
+ *
+ * @return True if the thread was pinned; false if pinning failed or isn't
+ * supported on the platform.
+ */
+bool pinCurrentThread(const CpuSet& cpus);
+}
@@ -0,0 +1,99 @@
+#include "chat/common/ByteRing.hpp"
+
+#include "chat/common/BufferView.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+
+namespace chat::common
+{
+
+ByteRing::ByteRing(std::size_t capacity)
+  : m_capacity{std::bit_ceil(std::max<std::size_t>(capacity, 1))},
+    m_mask{m_capacity - 1},
+    m_data(m_capacity),
+    m_writePosition{0},
+    m_cachedReadPosition{0},
+    m_readPosition{0},
+    m_cachedWritePosition{0}
+{}
+
+std::size_t ByteRing::getCapacity() const
+{
+    return m_capacity;
+}
+
+std::span<std::byte> ByteRing::getWritable()
+{
+    const std::size_t writePosition =
+        m_writePosition.load(std::memory_order_relaxed);
+
+    // The consumer's position is only reloaded when the cached one says the
+    // ring is full, which keeps the producer off the consumer's cache line
+    if(writePosition - m_cachedReadPosition == m_capacity) {
+        m_cachedReadPosition = m_readPosition.load(std::memory_order_acquire);
+    }
+
+    const std::size_t freeCount =
+        m_capacity - (writePosition - m_cachedReadPosition);
+    const std::size_t index = writePosition & m_mask;
+    return std::span{m_data}.subspan(
+        index, std::min(freeCount, m_capacity - index));
+}
+
+void ByteRing::commitWrite(std::size_t count)
+{
+    m_writePosition.store(m_writePosition.load(std::memory_order_relaxed) +
+                              count,
+                          std::memory_order_release);
+}
+
+std::size_t ByteRing::write(const BufferView& data)
+{
+    std::size_t written = 0;
+
+    // The free space is split in two when it wraps around the end of the ring
+    for(int i = 0; i < 2 && written < data.size(); i++) {
+        const auto writable = getWritable();
+        const std::size_t count =
+            std::min(writable.size(), data.size() - written);
+        if(count == 0) {
+            break;
+        }
+
+        std::copy_n(data.begin() + static_cast<std::ptrdiff_t>(written), count,
+                    writable.begin());
+        commitWrite(count);
+        written += count;
+    }
+
+    return written;
+}
+
+BufferView ByteRing::getReadable()
+{
+    const std::size_t readPosition =
+        m_readPosition.load(std::memory_order_relaxed);
+
+    // The producer's position is only reloaded when the cached one says the
+    // ring is empty, which keeps the consumer off the producer's cache line
+    if(readPosition == m_cachedWritePosition) {
+        m_cachedWritePosition = m_writePosition.load(std::memory_order_acquire);
+    }
+
+    const std::size_t usedCount = m_cachedWritePosition - readPosition;
+    const std::size_t index = readPosition & m_mask;
+    return BufferView{m_data}.subspan(index,
+                                      std::min(usedCount, m_capacity - index));
+}
+
+void ByteRing::commitRead(std::size_t count)
+{
+    m_readPosition.store(m_readPosition.load(std::memory_order_relaxed) + count,
+                         std::memory_order_release);
+}
+
+}
@@ -0,0 +1,120 @@
+#include "chat/common/Histogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace chat::common
+{
+
+namespace
+{
+// Every power of 2 is split into 2^subBucketBits buckets
+constexpr std::size_t subBucketBits = 3;
+constexpr std::size_t subBucketCount = std::size_t{1} << subBucketBits;
+}
+
+void Histogram::Snapshot::merge(const Snapshot& other)
+{
+    for(std::size_t i = 0; i < bucketCount; i++) {
+        m_counts.at(i) += other.m_counts.at(i);
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+std::uint64_t Histogram::Snapshot::getCount() const
+{
+    return m_count;
+}
+
+std::uint64_t Histogram::Snapshot::getSum() const
+{
+    return m_sum;
+}
+
+std::uint64_t Histogram::Snapshot::getPercentile(double percentile) const
+{
+    if(m_count == 0) {
+        return 0;
+    }
+
+    // The rank of the value, counting from 1, so that the 0th percentile is
+    // the smallest value
+    const auto rank = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(
+            std::ceil(static_cast<double>(m_count) * percentile / 100.0)),
+        1);
+
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < bucketCount; i++) {
+        seen += m_counts.at(i);
+        if(seen >= rank) {
+            return getUpperBound(i);
+        }
+    }
+
+    return std::numeric_limits<std::uint64_t>::max();
+}
+
+void Histogram::record(std::uint64_t value)
+{
+    // Only one thread records, so the increments don't need to be atomic
+    auto& count = m_counts.at(getBucket(value));
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    m_sum.store(m_sum.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::getSnapshot() const
+{
+    Snapshot snapshot;
+    for(std::size_t i = 0; i < bucketCount; i++) {
+        const auto count = m_counts.at(i).load(std::memory_order_relaxed);
+        snapshot.m_counts.at(i) = count;
+        snapshot.m_count += count;
+    }
+    snapshot.m_sum = m_sum.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+std::size_t Histogram::getBucket(std::uint64_t value)
+{
+    if(value < subBucketCount) {
+        return static_cast<std::size_t>(value);
+    }
+
+    // The top bits below the highest set bit pick the bucket within the power
+    // of 2
+    const auto exponent = static_cast<std::size_t>(std::bit_width(value) - 1);
+    const std::size_t shift = exponent - subBucketBits;
+    const auto subBucket =
+        static_cast<std::size_t>((value >> shift) & (subBucketCount - 1));
+    return ((shift + 1) * subBucketCount) + subBucket;
+}
+
+std::uint64_t Histogram::getUpperBound(std::size_t bucket)
+{
+    if(bucket + 1 >= bucketCount) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    // The largest value of a bucket is one less than the smallest value of the
+    // next bucket
+    const std::size_t next = bucket + 1;
+    if(next < subBucketCount) {
+        return next - 1;
+    }
+
+    const std::size_t shift = (next / subBucketCount) - 1;
+    const std::uint64_t lowerBound = (subBucketCount + (next % subBucketCount))
+                                     << shift;
+    return lowerBound - 1;
+}
+
+}
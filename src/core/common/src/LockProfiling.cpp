@@ -0,0 +1,160 @@
+#include "chat/common/LockProfiling.hpp"
+
+#include "chat/common/Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chat::common
+{
+
+namespace
+{
+/**
+ * @brief Every lock profile, and what destroyed ones recorded.
+ */
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<const detail::LockProfile*> profiles;
+    std::map<std::string, LockStats> retired;
+};
+
+/**
+ * @brief Get the registry.
+ *
+ * @details A profile gets the registry before it's registered, so the registry
+ * outlives every profile, including ones in static objects.
+ *
+ * @return The registry.
+ */
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+/**
+ * @brief Get the number of nanoseconds in a duration.
+ *
+ * @param duration The duration.
+ *
+ * @return The number of nanoseconds.
+ */
+std::uint64_t getNanoseconds(detail::LockProfile::Clock::duration duration)
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+}
+
+std::vector<LockStats> getLockStats()
+{
+    auto& registry = getRegistry();
+    const std::lock_guard lock{registry.mutex};
+    auto byName = registry.retired;
+    for(const auto* profile : registry.profiles) {
+        auto& stats = byName[profile->getName()];
+        stats.name = profile->getName();
+        profile->addTo(stats);
+    }
+
+    std::vector<LockStats> stats;
+    stats.reserve(byName.size());
+    for(auto& [name, lockStats] : byName) {
+        stats.push_back(std::move(lockStats));
+    }
+    return stats;
+}
+
+void logLockStats()
+{
+    // The stats are gathered before logging, since logging takes a lock that
+    // might be profiled too
+    for(const auto& stats : getLockStats()) {
+        LOG_INFO("Lock '{}': {} acquired, {} contended, wait p50 {} ns, "
+                 "p99 {} ns, hold p50 {} ns, p99 {} ns",
+                 stats.name, stats.acquireCount, stats.contendedCount,
+                 stats.wait.getPercentile(50), stats.wait.getPercentile(99),
+                 stats.hold.getPercentile(50), stats.hold.getPercentile(99));
+    }
+}
+
+namespace detail
+{
+LockProfile::LockProfile(LockName name)
+  : m_name{name.value},
+    m_wait{},
+    m_hold{}
+{
+    auto& registry = getRegistry();
+    const std::lock_guard lock{registry.mutex};
+    registry.profiles.push_back(this);
+}
+
+LockProfile::~LockProfile()
+{
+    auto& registry = getRegistry();
+    const std::lock_guard lock{registry.mutex};
+    std::erase(registry.profiles, this);
+    auto& stats = registry.retired[m_name];
+    stats.name = m_name;
+    addTo(stats);
+}
+
+LockProfile::Clock::time_point LockProfile::acquire(
+    std::unique_lock<std::mutex>& lock)
+{
+    if(lock.try_lock()) {
+        return adopt(Clock::time_point{}, false);
+    }
+
+    const auto start = Clock::now();
+    lock.lock();
+    return adopt(start, true);
+}
+
+LockProfile::Clock::time_point LockProfile::adopt(Clock::time_point start,
+                                                  bool contended)
+{
+    const auto acquiredAt = Clock::now();
+    if(!contended) {
+        m_wait.record(0);
+        return acquiredAt;
+    }
+
+    m_wait.record(getNanoseconds(acquiredAt - start));
+
+    // Only the thread holding the lock writes the count
+    m_contendedCount.store(m_contendedCount.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+    return acquiredAt;
+}
+
+void LockProfile::release(Clock::time_point acquiredAt)
+{
+    m_hold.record(getNanoseconds(Clock::now() - acquiredAt));
+}
+
+const std::string& LockProfile::getName() const
+{
+    return m_name;
+}
+
+void LockProfile::addTo(LockStats& stats) const
+{
+    const auto wait = m_wait.getSnapshot();
+    stats.acquireCount += wait.getCount();
+    stats.contendedCount += m_contendedCount.load(std::memory_order_relaxed);
+    stats.wait.merge(wait);
+    stats.hold.merge(m_hold.getSnapshot());
+}
+}
+
+}
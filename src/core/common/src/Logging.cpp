@@ -84,7 +84,7 @@ std::stringstream prepareLogEntry(Severity severity,
 }
 
 Logger::Logger()
-  : m_out{&std::cout}
+  : m_out{common::LockName{"Logger::out"}, &std::cout}
 {}
 
 void Logger::setOutputStream(std::ostream& out)
@@ -3,8 +3,14 @@
 #include "chat/common/BufferView.hpp"
 #include "chat/common/utility.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 namespace chat::common
 {
@@ -21,6 +27,11 @@ OutputByteStream& writeIntegral(OutputByteStream& out, const T& value)
 
 }
 
+OutputByteStream::OutputByteStream(std::size_t capacity)
+{
+    m_buffer.reserve(capacity);
+}
+
 void OutputByteStream::write(const BufferView& bytes)
 {
     m_buffer.insert(m_buffer.end(), bytes.begin(), bytes.end());
@@ -31,6 +42,37 @@ const Buffer& OutputByteStream::getData() const
     return m_buffer;
 }
 
+Buffer OutputByteStream::takeData()
+{
+    return std::exchange(m_buffer, Buffer{});
+}
+
+std::size_t OutputByteStream::reserveLength()
+{
+    const std::size_t position = m_buffer.size();
+    m_buffer.resize(position + sizeof(std::uint32_t));
+    return position;
+}
+
+void OutputByteStream::patchLength(std::size_t position)
+{
+    if(position > m_buffer.size() ||
+       m_buffer.size() - position < sizeof(std::uint32_t)) {
+        throw std::invalid_argument{"position is not a reserved length"};
+    }
+
+    const std::size_t length =
+        m_buffer.size() - position - sizeof(std::uint32_t);
+    if(length > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error{"length does not fit in a std::uint32_t"};
+    }
+
+    const auto bytes =
+        utility::toNetworkByteOrder(static_cast<std::uint32_t>(length));
+    std::ranges::copy(bytes, std::next(m_buffer.begin(),
+                                       static_cast<std::ptrdiff_t>(position)));
+}
+
 OutputByteStream& operator<<(OutputByteStream& out, std::int8_t value)
 {
     return writeIntegral(out, value);
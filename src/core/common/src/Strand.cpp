@@ -0,0 +1,95 @@
+#include "chat/common/Strand.hpp"
+
+#include "chat/common/Job.hpp"
+#include "chat/common/Logging.hpp"
+#include "chat/common/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace chat::common
+{
+
+Strand::State::State(ThreadPool& threadPool, ThreadPool::Priority priority)
+  : threadPool{threadPool},
+    priority{priority},
+    jobs{LockName{"Strand::jobs"}}
+{}
+
+Strand::Strand(ThreadPool& threadPool, ThreadPool::Priority priority)
+  : m_state{std::make_shared<State>(threadPool, priority)}
+{}
+
+void Strand::queue(Job job)
+{
+    {
+        auto jobs = m_state->jobs.lock();
+        jobs->queued.emplace_back(std::move(job));
+        if(jobs->running) {
+            return;
+        }
+
+        jobs->running = true;
+    }
+
+    m_state->threadPool.queue([state = m_state]() { run(state); },
+                              m_state->priority);
+}
+
+void Strand::run(const std::shared_ptr<State>& state)
+{
+    // No more jobs are taken than the runner has left to run, so a strand that
+    // keeps being fed still gives its thread back after the max. Taking every
+    // queued job is a swap, which takes them all under a single lock.
+    std::deque<Job> batch;
+    std::size_t runCount = 0;
+    while(true) {
+        {
+            auto jobs = state->jobs.lock();
+            if(jobs->queued.empty()) {
+                jobs->running = false;
+                return;
+            }
+
+            if(runCount >= maxRunCount) {
+                break;
+            }
+
+            const std::size_t takeCount = maxRunCount - runCount;
+            if(jobs->queued.size() <= takeCount) {
+                batch.swap(jobs->queued);
+            } else {
+                const auto end =
+                    jobs->queued.begin() +
+                    static_cast<std::deque<Job>::difference_type>(takeCount);
+                std::move(jobs->queued.begin(), end, std::back_inserter(batch));
+                jobs->queued.erase(jobs->queued.begin(), end);
+            }
+        }
+
+        for(auto& job : batch) {
+            // A job that throws must not stop the jobs after it from running
+            try {
+                job();
+            } catch(const std::exception& exception) {
+                LOG_ERROR("Exception caught: {}", exception.what());
+            } catch(...) {
+                LOG_ERROR("Unknown exception!");
+            }
+        }
+
+        runCount += batch.size();
+        batch.clear();
+    }
+
+    // The strand is still marked as running, so no other runner can be queued
+    // in the meantime
+    state->threadPool.queue([state]() { run(state); }, state->priority);
+}
+
+}
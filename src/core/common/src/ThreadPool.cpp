@@ -1,31 +1,194 @@
 #include "chat/common/ThreadPool.hpp"
 
+#include "chat/common/Job.hpp"
 #include "chat/common/Logging.hpp"
+#include "chat/common/affinity.hpp"
+#include "chat/common/utility.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
-#include <functional>
+#include <latch>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace chat::common
 {
 
-ThreadPool::ThreadPool(std::size_t threadCount)
-  : m_threadCount{threadCount},
+namespace
+{
+// The thread pool and the worker index of the current thread, which let jobs
+// queued by a pool's own threads skip the injection queue
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+
+/**
+ * @brief Get the lane of a priority.
+ *
+ * @param priority The priority.
+ *
+ * @return The index of the lane.
+ */
+std::size_t getLane(ThreadPool::Priority priority)
+{
+    return utility::toUnderlying(priority);
+}
+
+/**
+ * @brief Get the number of timer ticks in a duration, rounded up.
+ *
+ * @param duration The duration.
+ *
+ * @return The number of ticks, or 0 if the duration is negative.
+ */
+std::uint64_t getCeilTicks(ThreadPool::Clock::duration duration)
+{
+    const auto ticks =
+        (duration + ThreadPool::timerTick - ThreadPool::Clock::duration{1}) /
+        ThreadPool::timerTick;
+    return static_cast<std::uint64_t>(std::max<std::int64_t>(ticks, 0));
+}
+
+/**
+ * @brief Get the number of nanoseconds in a duration.
+ *
+ * @param duration The duration.
+ *
+ * @return The number of nanoseconds, or 0 if the duration is negative.
+ */
+std::uint64_t getNanoseconds(ThreadPool::Clock::duration duration)
+{
+    const auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return static_cast<std::uint64_t>(std::max<std::int64_t>(nanoseconds, 0));
+}
+
+/**
+ * @brief A job that resumes a suspended coroutine.
+ *
+ * @details The job owns the coroutine until it runs. A job that's destroyed
+ * without running, such as one still queued when its pool is destroyed,
+ * destroys the coroutine so that its frame isn't leaked.
+ */
+class Resumption
+{
+public:
+    explicit Resumption(std::coroutine_handle<> coroutine)
+      : m_coroutine{coroutine}
+    {}
+
+    Resumption(const Resumption& other) = delete;
+    Resumption& operator=(const Resumption& other) = delete;
+
+    Resumption(Resumption&& other) noexcept
+      : m_coroutine{std::exchange(other.m_coroutine, nullptr)}
+    {}
+
+    Resumption& operator=(Resumption&& other) = delete;
+
+    ~Resumption()
+    {
+        if(m_coroutine) {
+            m_coroutine.destroy();
+        }
+    }
+
+    void operator()()
+    {
+        std::exchange(m_coroutine, nullptr).resume();
+    }
+
+private:
+    std::coroutine_handle<> m_coroutine;
+};
+
+/**
+ * @brief Tell the CPU that the current thread is spinning.
+ *
+ * @details This lets the CPU save power and give its resources to the other
+ * hardware thread of its core while the current thread spins.
+ */
+void relaxCpu()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount, IdlePolicy idlePolicy,
+                       affinity::CpuSet cpus)
+  : ThreadPool{SizingPolicy::fixed(threadCount), idlePolicy, std::move(cpus)}
+{}
+
+ThreadPool::ThreadPool(SizingPolicy sizing, IdlePolicy idlePolicy,
+                       affinity::CpuSet cpus)
+  : m_sizing{sizing},
+    m_idlePolicy{idlePolicy},
+    m_cpus{std::move(cpus)},
     m_mutex{},
     m_stopping{false},
     m_pause{false},
-    m_idleCount{0},
+    m_queuedCounts{},
+    m_maxQueuedCount{0},
+    m_pendingCount{0},
+    m_sleepingCount{0},
+    m_threadCount{0},
+    m_threadStartCount{0},
+    m_threadRetireCount{0},
+    m_lastGrowth{},
     m_workCondvar{},
     m_idleCondvar{},
-    m_threads{},
-    m_jobs{}
+    m_injection{LockName{"ThreadPool::injection"}},
+    m_workers{},
+    m_timerStart{Clock::now()},
+    m_timerMutex{},
+    m_timerCondvar{},
+    m_timers{},
+    m_timerWakeTick{std::numeric_limits<std::uint64_t>::max()},
+    m_timerWaitingForWork{false},
+    m_timerThread{}
 {
-    m_threads.reserve(m_threadCount);
-    for(std::size_t i = 0; i < m_threadCount; i++) {
-        m_threads.emplace_back(&ThreadPool::threadLoop, this);
+    if(m_sizing.minThreadCount > m_sizing.maxThreadCount) {
+        throw std::invalid_argument{
+            "min thread count must not be greater than max thread count"};
+    }
+
+    if(isElastic() && m_sizing.minThreadCount < 1) {
+        throw std::invalid_argument{
+            "min thread count of an elastic thread pool must be greater than "
+            "0"};
+    }
+
+    // Every deque has to exist before any thread starts stealing, including
+    // the deques of the threads an elastic pool might start later
+    m_workers.reserve(m_sizing.maxThreadCount);
+    for(std::size_t i = 0; i < m_sizing.maxThreadCount; i++) {
+        m_workers.emplace_back(std::make_unique<Worker>());
+        m_workers.back()->index = i;
+        m_workers.back()->freeTasks.reserve(maxFreeTaskCount);
+    }
+
+    {
+        const std::unique_lock lock{m_mutex};
+        for(std::size_t i = 0; i < m_sizing.minThreadCount; i++) {
+            startWorker(*m_workers.at(i));
+        }
     }
+
+    m_timerThread = std::thread{&ThreadPool::timerLoop, this};
 }
 
 ThreadPool::~ThreadPool()
@@ -37,18 +200,106 @@ ThreadPool::~ThreadPool()
     m_workCondvar.notify_all();
     m_idleCondvar.notify_all();
 
-    for(auto& thread : m_threads) {
-        thread.join();
+    // The timer thread queues jobs, so it's stopped before the threads that
+    // run them
+    {
+        const std::unique_lock lock{m_timerMutex};
+    }
+    m_timerCondvar.notify_all();
+    m_timerThread.join();
+
+    for(auto& worker : m_workers) {
+        if(worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // The tasks that never ran are still owned by the deques
+    for(auto& worker : m_workers) {
+        for(auto& tasks : worker->tasks) {
+            while(const auto task = tasks.pop()) {
+                const std::unique_ptr<Task> owned{*task};
+            }
+        }
     }
 }
 
-void ThreadPool::queue(std::function<void()> job)
+void ThreadPool::queue(Job job, Priority priority)
 {
+    queueTasks(std::span{&job, 1}, nullptr, priority);
+}
+
+void ThreadPool::queue(std::span<Job> jobs, Priority priority)
+{
+    queueTasks(jobs, nullptr, priority);
+}
+
+void ThreadPool::queue(std::span<Job> jobs, std::latch& latch,
+                       Priority priority)
+{
+    queueTasks(jobs, &latch, priority);
+}
+
+void ThreadPool::run(std::span<Job> jobs, Priority priority)
+{
+    std::latch latch{static_cast<std::ptrdiff_t>(jobs.size())};
+    queueTasks(jobs, &latch, priority);
+    if(currentPool != this) {
+        latch.wait();
+        return;
+    }
+
+    // Blocking one of the pool's threads could leave no thread to run the
+    // batch, so the thread helps run jobs until the batch has finished
+    auto& worker = *m_workers.at(currentIndex);
+    while(!latch.try_wait()) {
+        if(!runTask(worker)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+ThreadPool::TimerId ThreadPool::queueAfter(Clock::duration delay, Job job,
+                                           Priority priority)
+{
+    return addTimer(delay, 0, std::move(job), priority);
+}
+
+ThreadPool::TimerId ThreadPool::queueEvery(Clock::duration period, Job job,
+                                           Priority priority)
+{
+    const std::uint64_t ticks =
+        std::max<std::uint64_t>(getCeilTicks(period), 1);
+    return addTimer(period, ticks, std::move(job), priority);
+}
+
+bool ThreadPool::cancel(TimerId timer)
+{
+    // The job is destroyed after the mutex is released
+    Job job;
     {
-        const std::unique_lock lock{m_mutex};
-        m_jobs.emplace(std::move(job));
+        const std::unique_lock lock{m_timerMutex};
+        auto* found = m_timers.find(timer);
+        if(found == nullptr) {
+            return false;
+        }
+
+        job = std::move(found->job);
+        m_timers.erase(timer);
     }
-    m_workCondvar.notify_one();
+
+    return true;
+}
+
+ThreadPool::ScheduleAwaitable ThreadPool::schedule(Priority priority)
+{
+    return ScheduleAwaitable{*this, priority};
+}
+
+void ThreadPool::ScheduleAwaitable::await_suspend(
+    std::coroutine_handle<> coroutine)
+{
+    m_pool.queue(Resumption{coroutine}, m_priority);
 }
 
 void ThreadPool::pause()
@@ -69,41 +320,663 @@ void ThreadPool::resume()
 void ThreadPool::waitForCompletion()
 {
     std::unique_lock lock{m_mutex};
-    m_idleCondvar.wait(lock, [this] {
-        return (m_idleCount == m_threadCount && m_jobs.empty()) || m_stopping;
-    });
+    m_idleCondvar.wait(lock,
+                       [this] { return m_pendingCount == 0 || m_stopping; });
 }
 
-void ThreadPool::threadLoop()
+std::size_t ThreadPool::getQueuedCount(Priority priority) const
 {
-    while(true) {
-        std::function<void()> job;
-        {
-            std::unique_lock lock{m_mutex};
-            m_idleCount++;
-            if(m_idleCount == m_threadCount && m_jobs.empty()) {
-                m_idleCondvar.notify_all();
+    return m_queuedCounts.at(getLane(priority));
+}
+
+std::size_t ThreadPool::getThreadCount() const
+{
+    return m_threadCount;
+}
+
+std::uint64_t ThreadPool::getThreadStartCount() const
+{
+    return m_threadStartCount;
+}
+
+std::uint64_t ThreadPool::getThreadRetireCount() const
+{
+    return m_threadRetireCount;
+}
+
+ThreadPool::Stats ThreadPool::getStats() const
+{
+    Stats stats;
+    for(const auto& worker : m_workers) {
+        stats.queueWait.merge(worker->queueWait.getSnapshot());
+        stats.runTime.merge(worker->runTime.getSnapshot());
+        stats.stealCount += worker->stealCount.load(std::memory_order_relaxed);
+        stats.idleCount += worker->idleCount.load(std::memory_order_relaxed);
+        stats.exceptionCount +=
+            worker->exceptionCount.load(std::memory_order_relaxed);
+    }
+    stats.maxQueuedCount = m_maxQueuedCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ThreadPool::threadLoop(std::size_t index)
+{
+    currentPool = this;
+    currentIndex = index;
+    auto& worker = *m_workers.at(index);
+
+    if(!affinity::pinCurrentThread(m_cpus)) {
+        LOG_WARN("Failed to pin thread pool thread {} to its CPUs", index);
+    }
+
+    // A thread pool being destroyed stops its threads even when jobs are
+    // still queued, since a job that keeps queueing jobs would never let it
+    while(!m_stopping) {
+        if(runTask(worker)) {
+            continue;
+        }
+        increment(worker.idleCount);
+
+        // A thread pool being destroyed counts as available work so that the
+        // spinning stops, but it's handled by the check at the top of the loop
+        if(spinForWork()) {
+            continue;
+        }
+
+        if(!waitForWork(worker)) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::timerLoop()
+{
+    if(!affinity::pinCurrentThread(m_cpus)) {
+        LOG_WARN("Failed to pin the thread pool's timer thread to its CPUs");
+    }
+
+    std::vector<TimerId> expired;
+    Lanes<std::vector<Job>> jobs;
+
+    // The last number of started jobs seen, and since when jobs have been
+    // waiting without any job being started
+    std::uint64_t startedCount = 0;
+    auto stalledSince = Clock::now();
+
+    // Whether the thread last slept without checking on jobs, so the jobs
+    // haven't been seen waiting since
+    bool waitedForWork = false;
+
+    std::unique_lock lock{m_timerMutex};
+    while(!m_stopping) {
+        if(isElastic()) {
+            const auto now = Clock::now();
+            const std::uint64_t newStartedCount = getStartedCount();
+            if(newStartedCount != startedCount || !hasQueuedTasks() ||
+               waitedForWork) {
+                startedCount = newStartedCount;
+                stalledSince = now;
+            } else {
+                lock.unlock();
+                growIfLagging(now - stalledSince);
+                lock.lock();
+
+                // The pool might have started stopping while the timer mutex
+                // was released, and the thread might not wake up again
+                if(m_stopping) {
+                    break;
+                }
+            }
+        }
+
+        m_timers.advance(getTimerTick(Clock::now()), expired);
+        for(const auto timer : expired) {
+            auto& found = *m_timers.find(timer);
+            auto& lane = jobs.at(getLane(found.priority));
+            if(found.period == 0) {
+                lane.emplace_back(std::move(found.job));
+                m_timers.erase(timer);
+            } else {
+                lane.emplace_back([this, timer] { runRepeatingJob(timer); });
+            }
+        }
+
+        if(!expired.empty()) {
+            // The jobs are queued after releasing the timer mutex so that
+            // threads adding and cancelling timers don't wait for the locks
+            // of the pool
+            expired.clear();
+            lock.unlock();
+            for(std::size_t i = 0; i < jobs.size(); i++) {
+                queue(jobs.at(i), static_cast<Priority>(i));
+                jobs.at(i).clear();
+            }
+            lock.lock();
+            continue;
+        }
+
+        // An elastic pool that can still grow also wakes up to check how long
+        // jobs have waited, but only while jobs are queued. The flag is set
+        // before the jobs are checked, and queueing counts a job before
+        // checking the flag, so either a job is seen here or queueing it wakes
+        // this thread.
+        auto nextTick = m_timers.getNextTick();
+        waitedForWork = false;
+        if(isElastic() && m_threadCount < m_sizing.maxThreadCount) {
+            m_timerWaitingForWork = true;
+            if(hasQueuedTasks()) {
+                m_timerWaitingForWork = false;
+                const std::uint64_t checkTick =
+                    getTimerTick(Clock::now() + m_sizing.targetQueueWait) + 1;
+                nextTick = std::min(nextTick.value_or(checkTick), checkTick);
+            } else {
+                waitedForWork = true;
             }
-            m_workCondvar.wait(lock, [this] {
-                return (!m_jobs.empty() && !m_pause) || m_stopping;
-            });
+        }
+
+        m_timerWakeTick =
+            nextTick.value_or(std::numeric_limits<std::uint64_t>::max());
+        if(nextTick.has_value()) {
+            m_timerCondvar.wait_until(lock,
+                                      m_timerStart + (*nextTick * timerTick));
+        } else {
+            m_timerCondvar.wait(lock);
+        }
+    }
+}
+
+ThreadPool::TimerId ThreadPool::addTimer(Clock::duration delay,
+                                         std::uint64_t period, Job job,
+                                         Priority priority)
+{
+    // The tick is rounded up so that the job never runs early
+    const std::uint64_t tick =
+        getCeilTicks(Clock::now() + delay - m_timerStart);
+
+    const std::unique_lock lock{m_timerMutex};
+    const TimerId timer = m_timers.insert(tick, Timer{.job = std::move(job),
+                                                      .priority = priority,
+                                                      .tick = tick,
+                                                      .period = period});
+    notifyTimer(tick);
+    return timer;
+}
+
+void ThreadPool::runRepeatingJob(TimerId timer)
+{
+    Job job;
+    {
+        const std::unique_lock lock{m_timerMutex};
+        auto* found = m_timers.find(timer);
+        if(found == nullptr) {
+            return;
+        }
+        job = std::move(found->job);
+    }
+
+    auto reschedule = [&] {
+        const std::unique_lock lock{m_timerMutex};
+        auto* found = m_timers.find(timer);
+        if(found == nullptr) {
+            return;
+        }
+
+        // The next run keeps to the job's period, skipping the runs that
+        // were missed
+        const std::uint64_t now = m_timers.getTick();
+        found->tick += found->period;
+        if(found->tick <= now) {
+            found->tick += ((now - found->tick) / found->period + 1) *
+                           found->period;
+        }
+        found->job = std::move(job);
+        m_timers.reschedule(timer, found->tick);
+        notifyTimer(found->tick);
+    };
+
+    try {
+        job();
+    } catch(...) {
+        // A job that throws still runs again, and the exception is logged by
+        // the thread that ran it
+        reschedule();
+        throw;
+    }
+    reschedule();
+}
+
+void ThreadPool::notifyTimer(std::uint64_t tick)
+{
+    if(tick < m_timerWakeTick) {
+        m_timerWakeTick = tick;
+        m_timerCondvar.notify_one();
+    }
+}
+
+std::uint64_t ThreadPool::getTimerTick(Clock::time_point time) const
+{
+    return static_cast<std::uint64_t>((time - m_timerStart) / timerTick);
+}
+
+void ThreadPool::queueTasks(std::span<Job> jobs, std::latch* latch,
+                            Priority priority)
+{
+    if(jobs.empty()) {
+        return;
+    }
+
+    const std::size_t lane = getLane(priority);
+    const auto queuedAt = Clock::now();
+    m_pendingCount += jobs.size();
+
+    // The tasks are counted before they can be taken, so a thread that takes
+    // one and uncounts it never takes the count below 0
+    m_queuedCounts.at(lane) += jobs.size();
+    if(currentPool == this) {
+        auto& worker = *m_workers.at(currentIndex);
+        for(auto& job : jobs) {
+            auto task = takeFreeTask(worker.freeTasks);
+            task->job = std::move(job);
+            task->latch = latch;
+            task->priority = priority;
+            task->queuedAt = queuedAt;
+            worker.tasks.at(lane).push(task.release());
+        }
+    } else {
+        auto injection = m_injection.lock();
+        for(auto& job : jobs) {
+            auto task = takeFreeTask(injection->freeTasks);
+            task->job = std::move(job);
+            task->latch = latch;
+            task->priority = priority;
+            task->queuedAt = queuedAt;
+            injection->queued.at(lane).emplace_back(std::move(task));
+        }
+    }
+
+    updateMaxQueuedCount();
+    notifyWork(jobs.size());
+
+    if(isElastic() && m_timerWaitingForWork.exchange(false)) {
+        const std::unique_lock lock{m_timerMutex};
+        notifyTimer(getTimerTick(queuedAt + m_sizing.targetQueueWait) + 1);
+    }
+}
+
+bool ThreadPool::runTask(Worker& worker)
+{
+    auto task = findTask(worker);
+    if(task == nullptr) {
+        return false;
+    }
+
+    const std::size_t lane = getLane(task->priority);
+    m_queuedCounts.at(lane)--;
+
+    // A task taken while the pool is being paused is put back rather than
+    // started. Like when it was queued, it's counted before it can be taken.
+    if(m_pause) {
+        m_queuedCounts.at(lane)++;
+        worker.tasks.at(lane).push(task.release());
+        return false;
+    }
+
+    const auto start = Clock::now();
+    const auto wait = start - task->queuedAt;
+    worker.queueWait.record(getNanoseconds(wait));
+    if(isElastic()) {
+        increment(worker.startedCount);
+        growIfLagging(wait);
+    }
+
+    try {
+        task->job();
+    } catch(const std::exception& exception) {
+        increment(worker.exceptionCount);
+        LOG_ERROR("Exception caught: {}", exception.what());
+    } catch(...) {
+        increment(worker.exceptionCount);
+        LOG_ERROR("Unknown exception!");
+    }
+    worker.runTime.record(getNanoseconds(Clock::now() - start));
+
+    // The job's captures are destroyed before anyone waiting for the job is
+    // notified
+    task->job.reset();
+    auto* latch = std::exchange(task->latch, nullptr);
+    freeTask(worker, std::move(task));
+    if(latch != nullptr) {
+        latch->count_down();
+    }
+    finishJob();
+
+    return true;
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::findTask(Worker& worker)
+{
+    if(worker.highPriorityStreak >= maxHighPriorityStreak) {
+        if(auto task = findTask(worker, Priority::Normal)) {
+            return task;
+        }
+
+        // No normal priority task is waiting, so there's nothing to starve
+        worker.highPriorityStreak = 0;
+    }
+
+    if(auto task = findTask(worker, Priority::High)) {
+        return task;
+    }
+
+    return findTask(worker, Priority::Normal);
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::findTask(Worker& worker,
+                                                       Priority priority)
+{
+    // Skips the locks and the stealing for an empty lane. A task that's
+    // counted after this check wakes the thread up again.
+    if(m_queuedCounts.at(getLane(priority)) == 0) {
+        return nullptr;
+    }
+
+    auto task = [&]() -> std::unique_ptr<Task> {
+        if(const auto popped = worker.tasks.at(getLane(priority)).pop()) {
+            return std::unique_ptr<Task>{*popped};
+        }
+
+        if(auto injected = takeInjectedTasks(worker, priority)) {
+            return injected;
+        }
+
+        auto stolen = stealTask(worker, priority);
+        if(stolen != nullptr) {
+            increment(worker.stealCount);
+        }
+        return stolen;
+    }();
+
+    if(task != nullptr) {
+        if(priority == Priority::High) {
+            worker.highPriorityStreak++;
+        } else {
+            worker.highPriorityStreak = 0;
+        }
+    }
+
+    return task;
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::takeInjectedTasks(
+    Worker& worker, Priority priority)
+{
+    std::unique_ptr<Task> task;
+    std::size_t batchSize = 0;
+    {
+        auto injection = m_injection.lock();
+        auto& tasks = injection->queued.at(getLane(priority));
+        if(tasks.empty()) {
+            return nullptr;
+        }
+
+        task = std::move(tasks.front());
+        tasks.pop_front();
+
+        // Leave a share of the tasks for each of the other threads
+        batchSize = std::min(tasks.size() / std::max<std::size_t>(
+                                                m_threadCount, 1),
+                             maxInjectedBatchSize);
+        for(std::size_t i = 0; i < batchSize; i++) {
+            worker.tasks.at(getLane(priority)).push(tasks.front().release());
+            tasks.pop_front();
+        }
+    }
+
+    // The batch can be stolen by sleeping threads
+    if(batchSize > 0) {
+        notifyWork(batchSize);
+    }
+
+    return task;
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::stealTask(const Worker& worker,
+                                                        Priority priority)
+{
+    for(std::size_t i = 1; i < m_workers.size(); i++) {
+        auto& victim = *m_workers.at((worker.index + i) % m_workers.size());
+        if(const auto task = victim.tasks.at(getLane(priority)).steal()) {
+            return std::unique_ptr<Task>{*task};
+        }
+    }
+
+    return nullptr;
+}
+
+bool ThreadPool::spinForWork() const
+{
+    // A spinning thread isn't counted as sleeping, so threads queueing jobs
+    // don't try to wake it
+    for(std::size_t i = 0; i < m_idlePolicy.spinCount; i++) {
+        if(isWorkAvailable()) {
+            return true;
+        }
+        relaxCpu();
+    }
+
+    for(std::size_t i = 0; i < m_idlePolicy.yieldCount; i++) {
+        if(isWorkAvailable()) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
 
-            if(m_stopping) {
-                return;
+    return false;
+}
+
+bool ThreadPool::isWorkAvailable() const
+{
+    return (hasQueuedTasks() && !m_pause) || m_stopping;
+}
+
+bool ThreadPool::waitForWork(Worker& worker)
+{
+    std::unique_lock lock{m_mutex};
+
+    // The count is raised before checking for jobs, so a thread queueing a job
+    // either sees this thread sleeping or this thread sees the job
+    m_sleepingCount++;
+    bool retire = false;
+    if(isElastic()) {
+        while(!m_workCondvar.wait_for(lock, m_sizing.idleTimeout,
+                                      [this] { return isWorkAvailable(); })) {
+            // A paused pool isn't idle, and the jobs it holds back might be
+            // in this thread's deque
+            if(!m_pause && m_threadCount > m_sizing.minThreadCount) {
+                retire = true;
+                break;
             }
+        }
+    } else {
+        m_workCondvar.wait(lock, [this] { return isWorkAvailable(); });
+    }
+    m_sleepingCount--;
+
+    if(retire) {
+        worker.active = false;
+        m_threadCount--;
+        m_threadRetireCount++;
+        LOG_DEBUG("Thread pool thread {} stopped after being idle, {} left",
+                  worker.index, m_threadCount.load());
+
+        // The timer thread stops checking on jobs while the pool is at its max,
+        // so it's woken now that the pool can grow again
+        lock.unlock();
+        const std::unique_lock timerLock{m_timerMutex};
+        notifyTimer(getTimerTick(Clock::now()));
+        return false;
+    }
+
+    return !m_stopping;
+}
+
+void ThreadPool::startWorker(Worker& worker)
+{
+    // A thread that has exited is still joinable
+    if(worker.thread.joinable()) {
+        worker.thread.join();
+    }
+
+    worker.active = true;
+    m_threadCount++;
+    worker.thread = std::thread{&ThreadPool::threadLoop, this, worker.index};
+}
+
+void ThreadPool::growIfLagging(Clock::duration wait)
+{
+    if(wait <= m_sizing.targetQueueWait ||
+       m_threadCount >= m_sizing.maxThreadCount) {
+        return;
+    }
+
+    const std::unique_lock lock{m_mutex};
+
+    // A sleeping thread can run the waiting jobs without starting another one
+    const auto now = Clock::now();
+    if(m_stopping || m_pause || m_sleepingCount > 0 ||
+       now - m_lastGrowth < m_sizing.targetQueueWait) {
+        return;
+    }
+
+    const auto inactive = std::ranges::find_if(
+        m_workers, [](const auto& worker) { return !worker->active; });
+    if(inactive == m_workers.end()) {
+        return;
+    }
+
+    startWorker(**inactive);
+    m_threadStartCount++;
+    m_lastGrowth = now;
+    LOG_DEBUG("Thread pool thread {} started after a job waited {} us, {} "
+              "running",
+              (*inactive)->index,
+              std::chrono::duration_cast<std::chrono::microseconds>(wait)
+                  .count(),
+              m_threadCount.load());
+}
+
+std::uint64_t ThreadPool::getStartedCount() const
+{
+    std::uint64_t count = 0;
+    for(const auto& worker : m_workers) {
+        count += worker->startedCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+void ThreadPool::updateMaxQueuedCount()
+{
+    // Each lane is read at a different time, so the sum is capped at what has
+    // been queued and not yet finished
+    std::size_t queuedCount = 0;
+    for(const auto& count : m_queuedCounts) {
+        queuedCount += count.load(std::memory_order_relaxed);
+    }
+    queuedCount = std::min(queuedCount,
+                           m_pendingCount.load(std::memory_order_relaxed));
 
-            job = m_jobs.front();
-            m_jobs.pop();
-            m_idleCount--;
+    // The mark is only written when it's raised, so queueing doesn't keep
+    // writing to a cache line that every queueing thread shares
+    auto max = m_maxQueuedCount.load(std::memory_order_relaxed);
+    while(queuedCount > max) {
+        if(m_maxQueuedCount.compare_exchange_weak(max, queuedCount,
+                                                  std::memory_order_relaxed)) {
+            break;
         }
+    }
+}
+
+void ThreadPool::increment(std::atomic_uint64_t& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+}
+
+bool ThreadPool::isElastic() const
+{
+    return m_sizing.minThreadCount < m_sizing.maxThreadCount;
+}
+
+bool ThreadPool::hasQueuedTasks() const
+{
+    return std::ranges::any_of(m_queuedCounts,
+                               [](const auto& count) { return count > 0; });
+}
+
+std::unique_ptr<ThreadPool::Task> ThreadPool::takeFreeTask(
+    std::vector<std::unique_ptr<Task>>& freeTasks)
+{
+    if(freeTasks.empty()) {
+        return std::make_unique<Task>();
+    }
+
+    auto task = std::move(freeTasks.back());
+    freeTasks.pop_back();
+    return task;
+}
+
+void ThreadPool::freeTask(Worker& worker, std::unique_ptr<Task> task)
+{
+    if(worker.freeTasks.size() < maxFreeTaskCount) {
+        worker.freeTasks.emplace_back(std::move(task));
+        return;
+    }
 
-        try {
-            job();
-        } catch(const std::exception& exception) {
-            LOG_ERROR("Exception caught: {}", exception.what());
-        } catch(...) {
-            LOG_ERROR("Unknown exception!");
+    // Threads that only run jobs free more tasks than they take, so half of
+    // their tasks are handed to the injection queue in a single lock, where
+    // they're taken by the threads outside of the pool that queue jobs
+    auto injection = m_injection.lock();
+    const std::size_t count = std::min(
+        maxFreeTaskCount / 2, maxFreeTaskCount - injection->freeTasks.size());
+    for(std::size_t i = 0; i < count; i++) {
+        injection->freeTasks.emplace_back(std::move(worker.freeTasks.back()));
+        worker.freeTasks.pop_back();
+    }
+
+    if(worker.freeTasks.size() < maxFreeTaskCount) {
+        worker.freeTasks.emplace_back(std::move(task));
+    }
+}
+
+void ThreadPool::notifyWork(std::size_t jobCount)
+{
+    const std::size_t sleepingCount = m_sleepingCount;
+    if(sleepingCount == 0) {
+        return;
+    }
+
+    // Taking the mutex makes sure a thread that's about to sleep has started
+    // waiting before it's notified
+    {
+        const std::unique_lock lock{m_mutex};
+    }
+
+    if(jobCount >= sleepingCount) {
+        m_workCondvar.notify_all();
+    } else {
+        for(std::size_t i = 0; i < jobCount; i++) {
+            m_workCondvar.notify_one();
+        }
+    }
+}
+
+void ThreadPool::finishJob()
+{
+    if(--m_pendingCount == 0) {
+        {
+            const std::unique_lock lock{m_mutex};
         }
+        m_idleCondvar.notify_all();
     }
 }
 
@@ -0,0 +1,98 @@
+#include "chat/common/affinity.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace chat::common::affinity
+{
+
+namespace
+{
+// Bounds both the CPU indexes and the number of CPUs in a parsed list, since a
+// range is expanded into every CPU in it
+constexpr std::size_t maxCpuCount = 4096;
+
+/**
+ * @brief Parse a CPU index.
+ *
+ * @param text The text to parse, which must only contain the index.
+ *
+ * @return The CPU index, or nothing if the text isn't a valid CPU index.
+ */
+std::optional<std::size_t> parseCpu(std::string_view text)
+{
+    std::size_t cpu = 0;
+    const auto* end = text.data() + text.size();
+    const auto [last, error] = std::from_chars(text.data(), end, cpu);
+    if(error != std::errc{} || last != end || cpu >= maxCpuCount) {
+        return std::nullopt;
+    }
+
+    return cpu;
+}
+}
+
+std::optional<CpuSet> parseCpuList(std::string_view list)
+{
+    CpuSet cpus;
+    while(true) {
+        const std::size_t comma = list.find(',');
+        const auto item = list.substr(0, comma);
+
+        const std::size_t dash = item.find('-');
+        const auto first = parseCpu(item.substr(0, dash));
+        const auto last = dash == std::string_view::npos
+                              ? first
+                              : parseCpu(item.substr(dash + 1));
+        if(!first.has_value() || !last.has_value() ||
+           first.value() > last.value()) {
+            return std::nullopt;
+        }
+        if(last.value() - first.value() >= maxCpuCount - cpus.size()) {
+            return std::nullopt;
+        }
+
+        for(std::size_t cpu = first.value(); cpu <= last.value(); cpu++) {
+            cpus.push_back(cpu);
+        }
+
+        if(comma == std::string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+
+    return cpus;
+}
+
+bool pinCurrentThread(const CpuSet& cpus)
+{
+    if(cpus.empty()) {
+        return true;
+    }
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(const std::size_t cpu : cpus) {
+        if(cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace chat::messages
+{
+/**
+ * @brief An identifier that pairs a response with the request it answers.
+ *
+ * @details The client chooses the identifier of each request, and the server
+ * gives a response the identifier of the request it answers. This lets a
+ * client have many requests in flight and match the responses to them even
+ * when they arrive in a different order.
+ */
+using CorrelationId = std::uint32_t;
+}
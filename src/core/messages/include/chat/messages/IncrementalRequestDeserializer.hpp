@@ -1,34 +1,173 @@
 #pragma once
 
+#include "chat/common/Buffer.hpp"
 #include "chat/common/BufferView.hpp"
 #include "chat/common/Result.hpp"
 #include "chat/messages/Request.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace chat::messages
 {
+/**
+ * @brief Deserializes requests from data that arrives in pieces.
+ *
+ * @details Data received from a stream, such as a socket, doesn't necessarily
+ * align with the boundaries of serialized requests. A serialized request might
+ * arrive over multiple receives, and a single receive might contain multiple
+ * serialized requests. The deserializer keeps the bytes of an incomplete
+ * serialized request until the rest of it arrives.
+ *
+ * Complete serialized requests are deserialized directly from the data provided
+ * by the caller. Only the bytes of an incomplete serialized request at the end
+ * of the data are copied into an internal buffer.
+ *
+ * The internal buffer tracks how far it has been read rather than erasing the
+ * bytes of each deserialized request. Read bytes are only removed when new
+ * bytes are appended, so each call moves the unread bytes at most once. The
+ * size of the serialized request at the read position is kept once known, so
+ * it isn't read again while waiting for the rest of the request.
+ */
 class IncrementalRequestDeserializer
 {
 public:
+    /**
+     * @brief The reason a request could not be deserialized.
+     */
     enum class FailureReason : std::uint8_t
     {
+        /**
+         * @brief Not enough data has been provided for a complete request.
+         */
         Partial,
+
+        /**
+         * @brief The data of a complete request is invalid.
+         */
         Error,
     };
 
+    /**
+     * @brief Try to deserialize a request.
+     *
+     * @details The data is appended to any data provided previously, and a
+     * request is deserialized from the start of it. Data that isn't used is
+     * kept for the next call.
+     *
+     * @param data The data to append.
+     *
+     * @return The request if one is deserialized; otherwise, the reason it
+     * could not be.
+     */
     common::Result<std::unique_ptr<Request>, FailureReason> tryDeserialize(
         const common::BufferView& data);
 
+    /**
+     * @brief Try to deserialize a request in place.
+     *
+     * @details The data is appended to any data provided previously, and a
+     * request is deserialized from the start of it. The bytes that are used are
+     * removed from the start of the view. If there is a complete request at
+     * the start of the view, it is deserialized in place without being copied.
+     *
+     * When the view only contains part of a request, its bytes are copied into
+     * the internal buffer and the view becomes empty. Calling this until it
+     * fails with @c FailureReason::Partial deserializes all the requests in
+     * the data.
+     *
+     * @param data The data to deserialize from.
+     *
+     * @return The request if one is deserialized; otherwise, the reason it
+     * could not be.
+     */
+    common::Result<std::unique_ptr<Request>, FailureReason>
+    tryDeserializeInPlace(common::BufferView& data);
+
+    /**
+     * @brief Deserialize all complete requests.
+     *
+     * @details The data is appended to any data provided previously, and every
+     * complete request is deserialized from it in a single pass. The bytes of
+     * an incomplete request at the end are kept for the next call.
+     *
+     * A result is appended for each complete request, in the order the
+     * requests appear in the data. A request that is invalid has a result with
+     * @c FailureReason::Error, and the requests after it are still
+     * deserialized.
+     *
+     * @param data The data to deserialize from.
+     *
+     * @param requests The results to append to.
+     */
+    void deserializeAll(
+        const common::BufferView& data,
+        std::vector<common::Result<std::unique_ptr<Request>, FailureReason>>&
+            requests);
+
 private:
-    void appendToBuffer(const common::BufferView& data);
+    /**
+     * @brief Move bytes from the data into the buffer until the buffer has a
+     * complete serialized request at its read position.
+     *
+     * @details Only the bytes needed to complete the serialized request are
+     * moved.
+     *
+     * @param data The data to move bytes from.
+     *
+     * @return True if the buffer has a complete serialized request at its read
+     * position; otherwise, false.
+     */
+    bool fillBuffer(common::BufferView& data);
 
-    std::optional<std::unique_ptr<Request>> deserialize(
-        std::size_t messageSize);
+    /**
+     * @brief Move bytes from the data into the buffer until the buffer has a
+     * minimum number of unread bytes.
+     *
+     * @param data The data to move bytes from.
+     *
+     * @param size The number of unread bytes the buffer should have.
+     */
+    void fillBufferTo(common::BufferView& data, std::size_t size);
+
+    /**
+     * @brief Deserialize the complete serialized request at the read position
+     * of the buffer.
+     *
+     * @details The read position is moved past the serialized request.
+     *
+     * @return The request if it is valid; otherwise, @c FailureReason::Error.
+     */
+    common::Result<std::unique_ptr<Request>, FailureReason>
+    deserializeFromBuffer();
+
+    /**
+     * @brief Get the number of unread bytes in the buffer.
+     *
+     * @return The number of unread bytes in the buffer.
+     */
+    [[nodiscard]] std::size_t getUnreadCount() const;
+
+    /**
+     * @brief Append bytes to the buffer.
+     *
+     * @details Bytes that have been read are removed from the buffer first.
+     *
+     * @param data The bytes to append.
+     */
+    void appendToBuffer(const common::BufferView& data);
 
-    void eraseFromStartOfBuffer(std::size_t messageSize);
+    /**
+     * @brief Remove the bytes that have been read from the start of the
+     * buffer.
+     */
+    void compactBuffer();
 
     common::Buffer m_buffer;
+    std::size_t m_readIndex = 0;
+    std::optional<std::size_t> m_frameSize;
 };
 }
@@ -2,6 +2,7 @@
 
 #include "chat/common/InputByteStream.hpp"
 #include "chat/common/OutputByteStream.hpp"
+#include "chat/messages/CorrelationId.hpp"
 
 #include <cstdint>
 
@@ -67,6 +68,26 @@ public:
      */
     [[nodiscard]] Type getType() const;
 
+    /**
+     * @brief Get the correlation ID of the request.
+     *
+     * @return The correlation ID of the request.
+     */
+    [[nodiscard]] CorrelationId getCorrelationId() const;
+
+    /**
+     * @brief Set the correlation ID of the request.
+     *
+     * @details The correlation ID is part of the frame header rather than the
+     * request's own data, so it is written and read by
+     * @c chat::messages::serialize() and
+     * @c chat::messages::deserializeRequest() instead of @c serialize() and
+     * @c deserialize().
+     *
+     * @param correlationId The correlation ID of the request.
+     */
+    void setCorrelationId(CorrelationId correlationId);
+
     /**
      * @brief Serialize into a stream.
      *
@@ -93,5 +114,6 @@ protected:
 
 private:
     Type m_type;
+    CorrelationId m_correlationId;
 };
 }
@@ -2,6 +2,7 @@
 
 #include "chat/common/InputByteStream.hpp"
 #include "chat/common/OutputByteStream.hpp"
+#include "chat/messages/CorrelationId.hpp"
 
 #include <cstdint>
 
@@ -66,6 +67,26 @@ public:
      */
     [[nodiscard]] Type getType() const;
 
+    /**
+     * @brief Get the correlation ID of the response.
+     *
+     * @return The correlation ID of the response.
+     */
+    [[nodiscard]] CorrelationId getCorrelationId() const;
+
+    /**
+     * @brief Set the correlation ID of the response.
+     *
+     * @details The correlation ID is part of the frame header rather than the
+     * response's own data, so it is written and read by
+     * @c chat::messages::serialize() and
+     * @c chat::messages::deserializeResponse() instead of @c serialize() and
+     * @c deserialize().
+     *
+     * @param correlationId The correlation ID of the response.
+     */
+    void setCorrelationId(CorrelationId correlationId);
+
     /**
      * @brief Serialize into a stream.
      *
@@ -92,5 +113,6 @@ protected:
 
 private:
     Type m_type;
+    CorrelationId m_correlationId;
 };
 }
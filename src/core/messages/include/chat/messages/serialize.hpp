@@ -13,6 +13,9 @@ namespace chat::messages
 /**
  * @brief Serialize a @c Request into a buffer.
  *
+ * @details The buffer is a frame, which starts with a header containing the
+ * size of the rest of the frame and the correlation ID of the @c Request.
+ *
  * @param request The @c Request to serialize.
  *
  * @return A buffer containing the serialized @c Request.
@@ -22,6 +25,9 @@ namespace chat::messages
 /**
  * @brief Serialize a @c Response into a buffer.
  *
+ * @details The buffer is a frame, which starts with a header containing the
+ * size of the rest of the frame and the correlation ID of the @c Response.
+ *
  * @param response The @c Response to serialize.
  *
  * @return A buffer containing the serialized @c Response.
@@ -7,71 +7,164 @@
 #include "chat/messages/Request.hpp"
 #include "chat/messages/serialize.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 namespace chat::messages
 {
+namespace
+{
+constexpr std::size_t messageSizeSize = sizeof(std::uint32_t);
+
+/**
+ * @brief Get the size of the serialized request at the start of the bytes.
+ *
+ * @param bytes The bytes starting with a serialized request.
+ *
+ * @return The size of the serialized request, including its size field, if the
+ * size field is complete; otherwise, no value.
+ */
+std::optional<std::size_t> getFrameSize(const common::BufferView& bytes)
+{
+    common::InputByteStream stream{bytes};
+    std::uint32_t messageSize = 0;
+    if(!(stream >> messageSize)) {
+        return {};
+    }
+
+    return messageSizeSize + messageSize;
+}
+
 common::Result<std::unique_ptr<Request>,
                IncrementalRequestDeserializer::FailureReason>
-IncrementalRequestDeserializer::tryDeserialize(const common::BufferView& data)
+deserializeFrame(const common::BufferView& frame)
 {
-    // This function can be optimized a lot more such saving the message size as
-    // a member of the class. However, keep it simple for now since the
-    // implementation does not affect the behavior of the function.
+    using FailureReason = IncrementalRequestDeserializer::FailureReason;
 
     common::Result<std::unique_ptr<Request>, FailureReason> result{
         common::Error{FailureReason::Error}};
+    auto request = messages::deserializeRequest(frame);
+    if(request.has_value()) {
+        result = std::move(request.value());
+    }
+    return result;
+}
+}
 
-    appendToBuffer(data);
+common::Result<std::unique_ptr<Request>,
+               IncrementalRequestDeserializer::FailureReason>
+IncrementalRequestDeserializer::tryDeserialize(const common::BufferView& data)
+{
+    auto unused = data;
+    auto result = tryDeserializeInPlace(unused);
+    appendToBuffer(unused);
+    return result;
+}
 
-    const common::BufferView bufferView{m_buffer.data(), m_buffer.size()};
-    common::InputByteStream bufferStream{bufferView};
+common::Result<std::unique_ptr<Request>,
+               IncrementalRequestDeserializer::FailureReason>
+IncrementalRequestDeserializer::tryDeserializeInPlace(common::BufferView& data)
+{
+    common::Result<std::unique_ptr<Request>, FailureReason> result{
+        common::Error{FailureReason::Partial}};
 
-    std::uint32_t messageSize = 0;
-    if(bufferStream >> messageSize) {
-        const std::size_t fullMessageSize = sizeof(messageSize) + messageSize;
-        if(m_buffer.size() >= fullMessageSize) {
-            auto request = deserialize(fullMessageSize);
-            if(request.has_value()) {
-                result = std::move(request.value());
-            } else {
-                result = common::Error{FailureReason::Error};
-            }
+    if(getUnreadCount() == 0) {
+        const auto frameSize = getFrameSize(data);
+        if(frameSize.has_value() && data.size() >= frameSize.value()) {
+            result = deserializeFrame(data.first(frameSize.value()));
+            data = data.subspan(frameSize.value());
         } else {
-            result = common::Error{FailureReason::Partial};
+            appendToBuffer(data);
+            data = {};
         }
-    } else {
-        result = common::Error{FailureReason::Partial};
+    } else if(fillBuffer(data)) {
+        result = deserializeFromBuffer();
     }
 
     return result;
 }
 
-void IncrementalRequestDeserializer::appendToBuffer(
-    const common::BufferView& data)
+void IncrementalRequestDeserializer::deserializeAll(
+    const common::BufferView& data,
+    std::vector<common::Result<std::unique_ptr<Request>, FailureReason>>&
+        requests)
 {
-    m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    auto unused = data;
+    while(true) {
+        auto result = tryDeserializeInPlace(unused);
+        if(!result.hasValue() && result.getError() == FailureReason::Partial) {
+            break;
+        }
+
+        requests.emplace_back(std::move(result));
+    }
+}
+
+bool IncrementalRequestDeserializer::fillBuffer(common::BufferView& data)
+{
+    if(!m_frameSize.has_value()) {
+        fillBufferTo(data, messageSizeSize);
+        m_frameSize = getFrameSize(
+            common::BufferView{m_buffer.data(), m_buffer.size()}.subspan(
+                m_readIndex));
+        if(!m_frameSize.has_value()) {
+            return false;
+        }
+    }
+
+    fillBufferTo(data, m_frameSize.value());
+    return getUnreadCount() >= m_frameSize.value();
+}
+
+void IncrementalRequestDeserializer::fillBufferTo(common::BufferView& data,
+                                                  std::size_t size)
+{
+    if(getUnreadCount() < size) {
+        const std::size_t count =
+            std::min(size - getUnreadCount(), data.size());
+        appendToBuffer(data.first(count));
+        data = data.subspan(count);
+    }
 }
 
-std::optional<std::unique_ptr<Request>>
-IncrementalRequestDeserializer::deserialize(std::size_t messageSize)
+common::Result<std::unique_ptr<Request>,
+               IncrementalRequestDeserializer::FailureReason>
+IncrementalRequestDeserializer::deserializeFromBuffer()
 {
-    const common::BufferView serialized{m_buffer.data(), messageSize};
-    auto request = messages::deserializeRequest(serialized);
-    eraseFromStartOfBuffer(messageSize);
-    return request;
+    const std::size_t frameSize = m_frameSize.value();
+    const common::BufferView frame{m_buffer.data() + m_readIndex, frameSize};
+    m_readIndex += frameSize;
+    m_frameSize.reset();
+    return deserializeFrame(frame);
+}
+
+std::size_t IncrementalRequestDeserializer::getUnreadCount() const
+{
+    return m_buffer.size() - m_readIndex;
+}
+
+void IncrementalRequestDeserializer::appendToBuffer(
+    const common::BufferView& data)
+{
+    if(data.empty()) {
+        return;
+    }
+
+    compactBuffer();
+    m_buffer.insert(m_buffer.end(), data.begin(), data.end());
 }
 
-void IncrementalRequestDeserializer::eraseFromStartOfBuffer(
-    std::size_t messageSize)
+void IncrementalRequestDeserializer::compactBuffer()
 {
     const auto endIt =
-        std::next(m_buffer.begin(), common::utility::makeSigned(messageSize));
+        std::next(m_buffer.begin(), common::utility::makeSigned(m_readIndex));
     m_buffer.erase(m_buffer.begin(), endIt);
+    m_readIndex = 0;
 }
 }
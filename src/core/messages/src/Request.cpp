@@ -1,6 +1,7 @@
 #include "chat/messages/Request.hpp"
 
 #include "chat/common/OutputByteStream.hpp"
+#include "chat/messages/CorrelationId.hpp"
 
 #include <type_traits>
 
@@ -11,12 +12,23 @@ Request::Type Request::getType() const
     return m_type;
 }
 
+CorrelationId Request::getCorrelationId() const
+{
+    return m_correlationId;
+}
+
+void Request::setCorrelationId(CorrelationId correlationId)
+{
+    m_correlationId = correlationId;
+}
+
 void Request::serialize(common::OutputByteStream& stream) const
 {
     stream << static_cast<std::underlying_type_t<Type>>(m_type);
 }
 
 Request::Request(Type type)
-  : m_type{type}
+  : m_type{type},
+    m_correlationId{0}
 {}
 }
@@ -1,6 +1,7 @@
 #include "chat/messages/Response.hpp"
 
 #include "chat/common/OutputByteStream.hpp"
+#include "chat/messages/CorrelationId.hpp"
 
 #include <type_traits>
 
@@ -11,12 +12,23 @@ Response::Type Response::getType() const
     return m_type;
 }
 
+CorrelationId Response::getCorrelationId() const
+{
+    return m_correlationId;
+}
+
+void Response::setCorrelationId(CorrelationId correlationId)
+{
+    m_correlationId = correlationId;
+}
+
 void Response::serialize(common::OutputByteStream& stream) const
 {
     stream << static_cast<std::underlying_type_t<Type>>(m_type);
 }
 
 Response::Response(Type type)
-  : m_type{type}
+  : m_type{type},
+    m_correlationId{0}
 {}
 }
@@ -4,11 +4,13 @@
 #include "chat/common/BufferView.hpp"
 #include "chat/common/InputByteStream.hpp"
 #include "chat/common/OutputByteStream.hpp"
+#include "chat/messages/CorrelationId.hpp"
 #include "chat/messages/Request.hpp"
 #include "chat/messages/Response.hpp"
 #include "chat/messages/request/Ping.hpp"
 #include "chat/messages/response/Pong.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <type_traits>
@@ -39,17 +41,21 @@ std::unique_ptr<Response> createResponse(Response::Type type)
     return response;
 }
 
+// Room for the frames of the current messages, which are only a few bytes, so
+// that serializing them allocates once
+constexpr std::size_t initialFrameCapacity = 64;
+
 template<typename Message>
 common::Buffer serializeMessage(const Message& message)
 {
-    common::OutputByteStream innerStream;
-    message.serialize(innerStream);
-    const auto inner = innerStream.getData();
-
-    common::OutputByteStream outerStream;
-    outerStream << inner;
-    const auto outer = outerStream.getData();
-    return outer;
+    // The frame header is the size of the rest of the frame followed by the
+    // correlation ID. The size is filled in once the rest has been written.
+    common::OutputByteStream stream{initialFrameCapacity};
+    const auto sizePosition = stream.reserveLength();
+    stream << message.getCorrelationId();
+    message.serialize(stream);
+    stream.patchLength(sizePosition);
+    return stream.takeData();
 }
 
 template<typename Message, typename Factory>
@@ -58,18 +64,22 @@ std::optional<std::unique_ptr<Message>> deserializeMessage(
 {
     common::InputByteStream outerStream{bytes};
 
-    common::Buffer inner;
+    common::BufferView inner;
     if(!(outerStream >> inner)) {
         return {};
     }
 
-    const common::BufferView innerView{inner.data(), inner.size()};
-    common::InputByteStream innerStream{innerView};
+    common::InputByteStream innerStream{inner};
 
     if(inner.size() != innerStream.getReadableCount()) {
         return {};
     }
 
+    CorrelationId correlationId = 0;
+    if(!(innerStream >> correlationId)) {
+        return {};
+    }
+
     std::underlying_type_t<typename Message::Type> typeValue{};
     if(!(innerStream >> typeValue)) {
         return {};
@@ -84,6 +94,8 @@ std::optional<std::unique_ptr<Message>> deserializeMessage(
         return {};
     }
 
+    message->setCorrelationId(correlationId);
+
     return message;
 }
 }
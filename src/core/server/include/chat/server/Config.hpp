@@ -0,0 +1,155 @@
+#pragma once
+
+#include "chat/common/affinity.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace chat::server
+{
+/**
+ * @brief How the threads that handle requests wait for more requests.
+ */
+enum class IdleProfile : std::uint8_t
+{
+    /**
+     * @brief Threads sleep as soon as they run out of requests.
+     *
+     * @details Idle threads don't use any CPU time, but a request that arrives
+     * while every thread is sleeping waits for a thread to be woken.
+     */
+    PowerSaving,
+
+    /**
+     * @brief Threads spin and yield for a while before sleeping.
+     *
+     * @details A request that arrives shortly after the previous one is picked
+     * up without waking a thread, at the cost of idle threads using CPU time.
+     */
+    LowLatency,
+};
+
+/**
+ * @brief Tunable settings for a @c Server.
+ *
+ * @details The default values are suitable for most uses.
+ */
+struct Config
+{
+    /**
+     * @brief The minimum size of a connection's receive buffer, in bytes.
+     *
+     * @details A connection's receive buffer starts at this size and never
+     * shrinks below it. This is the memory an idle connection uses for its
+     * receive buffer.
+     */
+    std::size_t minReceiveBufferSize = 256;
+
+    /**
+     * @brief The maximum size of a connection's receive buffer, in bytes.
+     *
+     * @details A connection's receive buffer grows up to this size while the
+     * client sends data faster than it is received.
+     */
+    std::size_t maxReceiveBufferSize = 64 * 1024;
+
+    /**
+     * @brief The time a connection waits for data before its receive buffer
+     * shrinks to @c minReceiveBufferSize.
+     */
+    std::chrono::milliseconds receiveBufferIdleTimeout{1000};
+
+    /**
+     * @brief The capacity of the ring that hands a connection's received data
+     * to its handler, in bytes.
+     *
+     * @details It's rounded up to the next power of 2. When the ring is full,
+     * the connection stops receiving until the handler has caught up.
+     */
+    std::size_t receiveRingCapacity = 64 * 1024;
+
+    /**
+     * @brief The number of threads that perform socket I/O.
+     *
+     * @details Each thread runs a shard of the server with its own listener
+     * and connections. With more than one thread, the listeners share the port
+     * with @c SO_REUSEPORT, and the operating system spreads incoming
+     * connections across them.
+     */
+    std::size_t ioThreadCount = 1;
+
+    /**
+     * @brief The number of bytes waiting to be sent to a client at which its
+     * connection stops receiving.
+     *
+     * @details A client that doesn't read its responses would otherwise make
+     * the server keep an unbounded number of bytes for it. Requests that were
+     * already received are still handled, so the number of waiting bytes can
+     * exceed this by a bounded amount.
+     */
+    std::size_t sendHighWaterMark = 1024 * 1024;
+
+    /**
+     * @brief The number of bytes waiting to be sent to a client at which its
+     * connection resumes receiving after reaching the high water mark.
+     *
+     * @details The gap between the water marks keeps a connection from
+     * switching between receiving and not receiving on every send.
+     */
+    std::size_t sendLowWaterMark = 256 * 1024;
+
+    /**
+     * @brief How the threads that handle requests wait for more requests.
+     */
+    IdleProfile idleProfile = IdleProfile::PowerSaving;
+
+    /**
+     * @brief The fewest threads that handle requests, or nothing for a fixed
+     * number of threads.
+     *
+     * @details When set, the server starts with this many threads and starts
+     * more, up to its max thread count, while requests wait longer than
+     * @c workerQueueWaitTarget to be handled. Threads that are idle for
+     * @c workerIdleTimeout are stopped again.
+     */
+    std::optional<std::size_t> minWorkerThreadCount;
+
+    /**
+     * @brief The longest a request should wait for a thread before another
+     * thread is started.
+     *
+     * @details This only applies when @c minWorkerThreadCount is set.
+     */
+    std::chrono::milliseconds workerQueueWaitTarget{10};
+
+    /**
+     * @brief The time a thread that handles requests is idle for before it's
+     * stopped.
+     *
+     * @details This only applies when @c minWorkerThreadCount is set.
+     */
+    std::chrono::milliseconds workerIdleTimeout{30000};
+
+    /**
+     * @brief The CPUs the threads that perform socket I/O are pinned to.
+     *
+     * @details Each thread is pinned to a single CPU, taken from the set in
+     * order and wrapping around when there are more threads than CPUs. The
+     * thread that runs the server is the first of these threads. A thread's
+     * connections and their buffers are allocated on the thread, so they're
+     * placed on the thread's NUMA node. An empty set leaves the threads
+     * unpinned.
+     */
+    common::affinity::CpuSet ioThreadCpus;
+
+    /**
+     * @brief The CPUs the threads that handle requests may run on.
+     *
+     * @details Every thread may run on any CPU in the set. An empty set leaves
+     * the threads unpinned.
+     */
+    common::affinity::CpuSet workerThreadCpus;
+};
+}
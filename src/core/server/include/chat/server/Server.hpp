@@ -1,6 +1,8 @@
 #pragma once
 
 #include "chat/common/Port.hpp"
+#include "chat/server/Config.hpp"
+#include "chat/server/Stats.hpp"
 
 #include <cstddef>
 #include <memory>
@@ -22,8 +24,11 @@ public:
      * @param port The port to listen on.
      *
      * @param maxThreadCount The number of threads for the server to use.
+     *
+     * @param config The tunable settings of the server.
      */
-    Server(common::Port port, std::size_t maxThreadCount);
+    Server(common::Port port, std::size_t maxThreadCount,
+           const Config& config = {});
 
     /**
      * @brief Copy operations are disabled.
@@ -60,6 +65,15 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Get a snapshot of the server's counters.
+     *
+     * @details This can be called from any thread.
+     *
+     * @return A snapshot of the server's counters.
+     */
+    [[nodiscard]] Stats getStats() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "chat/common/Histogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace chat::server
+{
+/**
+ * @brief A snapshot of a @c Server's counters.
+ *
+ * @details The counters are aggregated over all connections and the thread
+ * pool. Each counter is read on its own, so the values might not all be from
+ * the same instant.
+ */
+struct Stats
+{
+    /**
+     * @brief The number of bytes waiting to be sent to clients.
+     */
+    std::size_t queuedSendBytes = 0;
+
+    /**
+     * @brief The number of connections that have stopped receiving because
+     * too many bytes are waiting to be sent to their clients.
+     */
+    std::size_t sendBlockedConnectionCount = 0;
+
+    /**
+     * @brief The number of times a connection has stopped receiving because
+     * too many bytes were waiting to be sent to its client.
+     */
+    std::uint64_t sendBlockCount = 0;
+
+    /**
+     * @brief The number of high priority jobs waiting to be started by the
+     * thread pool.
+     */
+    std::size_t queuedHighPriorityJobCount = 0;
+
+    /**
+     * @brief The number of normal priority jobs waiting to be started by the
+     * thread pool.
+     */
+    std::size_t queuedNormalPriorityJobCount = 0;
+
+    /**
+     * @brief The number of threads of the thread pool that are running.
+     */
+    std::size_t workerThreadCount = 0;
+
+    /**
+     * @brief The number of threads the thread pool has started because jobs
+     * were waiting.
+     */
+    std::uint64_t workerThreadStartCount = 0;
+
+    /**
+     * @brief The number of threads the thread pool has stopped because they
+     * were idle.
+     */
+    std::uint64_t workerThreadRetireCount = 0;
+
+    /**
+     * @brief The time from queueing a job into the thread pool to starting
+     * it, in nanoseconds.
+     *
+     * @details Together with @c jobRunTime, this tells apart requests that
+     * are slow because they wait for a thread from requests that are slow to
+     * handle.
+     */
+    common::Histogram::Snapshot jobQueueWait;
+
+    /**
+     * @brief The time a job of the thread pool ran for, in nanoseconds.
+     */
+    common::Histogram::Snapshot jobRunTime;
+
+    /**
+     * @brief The most jobs that have been waiting to be started by the thread
+     * pool at once.
+     */
+    std::size_t maxQueuedJobCount = 0;
+
+    /**
+     * @brief The number of jobs a thread of the thread pool took from another
+     * thread.
+     */
+    std::uint64_t jobStealCount = 0;
+
+    /**
+     * @brief The number of times a thread of the thread pool ran out of jobs.
+     */
+    std::uint64_t workerIdleCount = 0;
+
+    /**
+     * @brief The number of jobs of the thread pool that threw an exception.
+     */
+    std::uint64_t jobExceptionCount = 0;
+};
+}
@@ -1,40 +1,94 @@
 #include "Connection.hpp"
 
 #include "ConnectionManager.hpp"
+#include "Counters.hpp"
 #include "Formatter.hpp" // NOLINT(misc-include-cleaner)
+#include "RequestHandler.hpp"
 
+#include "chat/common/Buffer.hpp"
+#include "chat/common/BufferView.hpp"
+#include "chat/common/Job.hpp"
 #include "chat/common/Logging.hpp"
+#include "chat/common/SharedBuffer.hpp"
+#include "chat/common/Strand.hpp"
 #include "chat/common/ThreadPool.hpp"
+#include "chat/messages/IncrementalRequestDeserializer.hpp"
+#include "chat/messages/Request.hpp"
+#include "chat/messages/serialize.hpp"
+#include "chat/server/Config.hpp"
 
+#include <asio/awaitable.hpp>
 #include <asio/buffer.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/detached.hpp>
 #include <asio/error_code.hpp>
 #include <asio/ip/tcp.hpp>
+#include <asio/post.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/use_awaitable.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
-#include <sstream>
-#include <string>
+#include <iterator>
+#include <memory>
+#include <span>
 #include <utility>
-
-// TODO: Remove includes
-#include "chat/common/utility.hpp"
+#include <vector>
 
 namespace chat::server
 {
-Connection::Connection(asio::ip::tcp::socket&& socket,
+Connection::Connection(asio::ip::tcp::socket&& socket, ConnectionId id,
                        ConnectionManager& connectionManager,
-                       common::ThreadPool& threadPool)
+                       RequestHandler& requestHandler,
+                       common::ThreadPool& threadPool, const Config& config,
+                       Counters& counters)
   : m_socket{std::move(socket)},
+    m_id{id},
     m_connectionManager{connectionManager},
+    m_requestHandler{requestHandler},
     m_threadPool{threadPool},
+    m_config{config},
+    m_counters{counters},
     m_remoteEndpoint{},
-    m_receiveBufferStage1{},
-    m_receiveBufferStage2{},
-    m_sendBufferStage1{},
-    m_sendBufferStage2{}
+    m_receiveBufferSizer{m_config.minReceiveBufferSize,
+                         m_config.maxReceiveBufferSize},
+    m_receiveBufferStage1(m_receiveBufferSizer.getSize()),
+    m_untransferredData{},
+    m_lastReceiveSize{0},
+    m_receiveIdleTimer{m_socket.get_executor()},
+    m_waitingForData{false},
+    m_receiveBufferStage2{m_config.receiveRingCapacity},
+    // The strand's jobs handle the requests that aren't concurrent inline, so
+    // they run at normal priority, and only control requests are queued at high
+    // priority
+    m_strand{threadPool},
+    m_receivePaused{false},
+    m_receiveBlocked{false},
+    m_deserializer{},
+    m_requests{},
+    m_concurrentJobs{},
+    m_sendQueueStage1{common::LockName{"Connection::sendQueueStage1"}},
+    m_sendQueueStage2{},
+    m_sendOffset{0},
+    m_queuedSendBytes{0},
+    m_sendBuffers{}
 {
     setRemoteEndpoint();
 }
 
+Connection::~Connection()
+{
+    m_counters.queuedSendBytes.fetch_sub(
+        m_queuedSendBytes.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    if(m_receiveBlocked) {
+        m_counters.sendBlockedConnectionCount.fetch_sub(
+            1, std::memory_order_relaxed);
+    }
+}
+
 void Connection::start()
 {
     LOG_DEBUG("{}: started connection", m_remoteEndpoint);
@@ -60,7 +114,12 @@ void Connection::stop()
         LOG_WARN("{}: failed to close socket, {}", m_remoteEndpoint, ec);
     }
 
-    m_connectionManager.remove(*this);
+    m_connectionManager.remove(m_id);
+}
+
+ConnectionId Connection::getId() const
+{
+    return m_id;
 }
 
 void Connection::setRemoteEndpoint()
@@ -94,132 +153,355 @@ void Connection::setRemoteEndpoint()
 
 void Connection::startReceive()
 {
-    LOG_DEBUG("{}: started receive", m_remoteEndpoint);
-    m_socket.async_receive(asio::buffer(m_receiveBufferStage1),
-                           [self = shared_from_this()](
-                               asio::error_code ec, std::size_t bytesReceived) {
-                               self->receiveToken(ec, bytesReceived);
-                           });
+    // The coroutine holds onto the function object that created it, which
+    // keeps the connection alive until the coroutine returns
+    asio::co_spawn(
+        m_socket.get_executor(),
+        [self = shared_from_this()]() { return self->receiveLoop(); },
+        asio::detached);
 }
 
-void Connection::receiveToken(asio::error_code ec, std::size_t bytesReceived)
+asio::awaitable<void> Connection::receiveLoop()
 {
+    // A receive that didn't fill the buffer means the client has caught up, so
+    // the buffer isn't tied up in the next receive until data arrives
+    bool caughtUp = false;
+    do {
+        if(caughtUp &&
+           m_receiveBufferStage1.size() > m_receiveBufferSizer.getMinSize() &&
+           !co_await waitForData()) {
+            co_return;
+        }
+
+        LOG_DEBUG("{}: started receive", m_remoteEndpoint);
+        asio::error_code ec;
+        const std::size_t bytesReceived = co_await m_socket.async_receive(
+            asio::buffer(m_receiveBufferStage1),
+            asio::redirect_error(asio::use_awaitable, ec));
+        if(ec) {
+            LOG_WARN("{}: failed to receive, {}", m_remoteEndpoint, ec);
+            stop();
+            co_return;
+        }
+
+        LOG_DEBUG("{}: received {} bytes", m_remoteEndpoint, bytesReceived);
+        m_untransferredData =
+            common::BufferView{m_receiveBufferStage1.data(), bytesReceived};
+        m_lastReceiveSize = bytesReceived;
+        caughtUp = bytesReceived < m_receiveBufferStage1.size();
+    } while(continueReceive());
+}
+
+asio::awaitable<bool> Connection::waitForData()
+{
+    // The timer's handler runs on the socket's executor, like this coroutine,
+    // so the flag doesn't need to be synchronized. It keeps a handler that was
+    // already queued when the wait finished from shrinking the buffer while a
+    // receive is using it.
+    m_waitingForData = true;
+    m_receiveIdleTimer.expires_after(m_config.receiveBufferIdleTimeout);
+    m_receiveIdleTimer.async_wait(
+        [self = shared_from_this()](asio::error_code ec) {
+            if(!ec) {
+                self->shrinkIdleReceiveBuffer();
+            }
+        });
+
+    asio::error_code ec;
+    co_await m_socket.async_wait(asio::ip::tcp::socket::wait_read,
+                                 asio::redirect_error(asio::use_awaitable, ec));
+    m_waitingForData = false;
+    m_receiveIdleTimer.cancel();
     if(ec) {
-        LOG_WARN("{}: failed to receive, {}", m_remoteEndpoint, ec);
+        LOG_WARN("{}: failed to wait for data, {}", m_remoteEndpoint, ec);
         stop();
+        co_return false;
+    }
+
+    co_return true;
+}
+
+void Connection::shrinkIdleReceiveBuffer()
+{
+    if(!m_waitingForData || !m_receiveBufferSizer.shrinkForIdle()) {
         return;
     }
 
-    LOG_DEBUG("{}: received {} bytes", m_remoteEndpoint, bytesReceived);
-    if(transferReceiveBuffers(bytesReceived)) {
-        m_threadPool.queue(
-            [self = shared_from_this()]() { self->handleReceivedDataLoop(); });
+    LOG_DEBUG("{}: shrank idle receive buffer from {} to {} bytes",
+              m_remoteEndpoint, m_receiveBufferStage1.size(),
+              m_receiveBufferSizer.getSize());
+    m_receiveBufferStage1 = common::Buffer(m_receiveBufferSizer.getSize());
+}
+
+bool Connection::continueReceive()
+{
+    if(!transferReceiveBuffers()) {
+        LOG_DEBUG("{}: paused receive", m_remoteEndpoint);
+        return false;
+    }
+
+    resizeReceiveBufferStage1(m_lastReceiveSize);
+
+    const std::size_t queuedSendBytes =
+        m_queuedSendBytes.load(std::memory_order_relaxed);
+    if(queuedSendBytes >= m_config.sendHighWaterMark) {
+        LOG_DEBUG("{}: blocked receive, {} bytes waiting to be sent",
+                  m_remoteEndpoint, queuedSendBytes);
+        m_receiveBlocked = true;
+        m_counters.sendBlockedConnectionCount.fetch_add(
+            1, std::memory_order_relaxed);
+        m_counters.sendBlockCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
 
-    startReceive();
+    return true;
 }
 
 void Connection::handleReceivedDataLoop()
 {
     while(true) {
-        auto data = extractReceiveBufferStage2();
+        const auto data = m_receiveBufferStage2.getReadable();
         if(data.empty()) {
             break;
         }
 
-        handleReceivedData(std::move(data));
+        handleReceivedData(data);
     }
 }
 
-void Connection::handleReceivedData(common::Buffer data)
+void Connection::handleReceivedData(const common::BufferView& data)
 {
-    // TODO: This handling logic is only for testing purposes. It needs to be
-    // forwarded to some message parser for the application logic.
-    std::ostringstream stream;
-    common::utility::hexdump(stream,
-                             common::BufferView{data.data(), data.size()});
-    LOG_DEBUG("{}", stream.str());
+    m_deserializer.deserializeAll(data, m_requests);
+    consumeReceiveBufferStage2(data.size());
+
+    // Control requests are always queued at high priority, so they're handled
+    // ahead of bulk work even though the strand runs at normal priority
+    queueConcurrentRequests(common::ThreadPool::Priority::High);
 
-    const std::string response = "hello client, this is the server";
-    send(common::BufferView{reinterpret_cast<const std::byte*>(response.data()),
-                            response.size()});
+    // A single request is handled on the current thread since there is nothing
+    // to run it in parallel with, which skips a hop through the thread pool
+    if(m_requests.size() > 1) {
+        queueConcurrentRequests(common::ThreadPool::Priority::Normal);
+    }
+
+    for(auto& result : m_requests) {
+        if(!result.hasValue()) {
+            LOG_WARN("{}: failed to deserialize request", m_remoteEndpoint);
+            continue;
+        }
+
+        // The requests that were queued were moved out of their results
+        const auto& request = result.getValue();
+        if(request != nullptr) {
+            handleRequest(*request);
+        }
+    }
+
+    // The requests are cleared rather than the container being recreated so
+    // that its memory is reused for the next received data
+    m_requests.clear();
 }
 
-void Connection::send(common::BufferView data)
+void Connection::queueConcurrentRequests(common::ThreadPool::Priority priority)
 {
-    if(insertSendBufferStage1(data)) {
-        startSend();
+    for(auto& result : m_requests) {
+        if(!result.hasValue() || result.getValue() == nullptr) {
+            continue;
+        }
+
+        const auto& request = *result.getValue();
+        if(m_requestHandler.isConcurrent(request) &&
+           m_requestHandler.getPriority(request) == priority) {
+            m_concurrentJobs.emplace_back(
+                [self = shared_from_this(),
+                 request = std::move(result.getValue())]() {
+                    self->handleRequest(*request);
+                });
+        }
     }
+
+    m_threadPool.queue(m_concurrentJobs, priority);
+
+    // The jobs are cleared rather than the container being recreated so that
+    // its memory is reused for the next batch
+    m_concurrentJobs.clear();
 }
 
-void Connection::startSend()
+void Connection::handleRequest(const messages::Request& request)
 {
-    transferSendBuffers();
-    if(m_sendBufferStage2.empty()) {
+    auto response = m_requestHandler.handle(request);
+    if(response == nullptr) {
+        LOG_ERROR("{}: no response for request", m_remoteEndpoint);
         return;
     }
 
-    LOG_DEBUG("{}: started send", m_remoteEndpoint);
-    m_socket.async_send(asio::buffer(m_sendBufferStage2),
-                        [self = shared_from_this()](asio::error_code ec,
-                                                    std::size_t bytesSent) {
-                            self->sendToken(ec, bytesSent);
-                        });
+    response->setCorrelationId(request.getCorrelationId());
+
+    send(std::make_shared<const common::Buffer>(
+        messages::serialize(*response)));
 }
 
-void Connection::sendToken(asio::error_code ec, std::size_t bytesSent)
+void Connection::send(common::SharedBuffer frame)
 {
-    if(ec) {
-        LOG_WARN("{}: failed to send, {}", m_remoteEndpoint, ec);
-        stop();
-        return;
+    m_queuedSendBytes.fetch_add(frame->size(), std::memory_order_relaxed);
+    m_counters.queuedSendBytes.fetch_add(frame->size(),
+                                         std::memory_order_relaxed);
+    if(insertSendQueueStage1(std::move(frame))) {
+        // The coroutine starts by posting itself to the socket's executor, so
+        // the socket is never used by multiple threads at the same time
+        asio::co_spawn(
+            m_socket.get_executor(),
+            [self = shared_from_this()]() { return self->sendLoop(); },
+            asio::detached);
     }
+}
+
+asio::awaitable<void> Connection::sendLoop()
+{
+    while(transferSendQueues()) {
+        const std::size_t bufferCount =
+            std::min(m_sendQueueStage2.size(), m_sendBuffers.size());
+        for(std::size_t i = 0; i < bufferCount; i++) {
+            const auto& frame = *m_sendQueueStage2.at(i);
+            const std::size_t offset = i == 0 ? m_sendOffset : 0;
+            m_sendBuffers.at(i) =
+                asio::buffer(frame.data() + offset, frame.size() - offset);
+        }
+
+        LOG_DEBUG("{}: started send", m_remoteEndpoint);
+        asio::error_code ec;
+        const std::size_t bytesSent = co_await m_socket.async_send(
+            std::span{m_sendBuffers.data(), bufferCount},
+            asio::redirect_error(asio::use_awaitable, ec));
+        if(ec) {
+            LOG_WARN("{}: failed to send, {}", m_remoteEndpoint, ec);
+            stop();
+            co_return;
+        }
+
+        LOG_DEBUG("{}: sent {} bytes", m_remoteEndpoint, bytesSent);
+        consumeSendQueueStage2(bytesSent);
+
+        // Receiving is only blocked and unblocked on the socket's executor, so
+        // the flag doesn't need to be synchronized
+        const bool belowLowWaterMark =
+            m_queuedSendBytes.load(std::memory_order_relaxed) <=
+            m_config.sendLowWaterMark;
+        if(m_receiveBlocked && belowLowWaterMark) {
+            LOG_DEBUG("{}: unblocked receive", m_remoteEndpoint);
+            m_receiveBlocked = false;
+            m_counters.sendBlockedConnectionCount.fetch_sub(
+                1, std::memory_order_relaxed);
+            startReceive();
+        }
+    }
+}
+
+bool Connection::transferReceiveBuffers()
+{
+    while(true) {
+        const std::size_t transferred =
+            m_receiveBufferStage2.write(m_untransferredData);
+        m_untransferredData = m_untransferredData.subspan(transferred);
+        if(transferred > 0) {
+            notifyReceivedData();
+        }
+
+        if(m_untransferredData.empty()) {
+            return true;
+        }
+
+        // The pause is published before checking the ring again, and the
+        // handler frees space before checking the pause. The fences guarantee
+        // that at least one side sees the other, so receiving can't be left
+        // paused while the ring has space.
+        m_receivePaused.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_receiveBufferStage2.getWritable().empty()) {
+            return false;
+        }
 
-    LOG_DEBUG("{}: sent {} bytes", m_remoteEndpoint, bytesSent);
-    auto endIt =
-        m_sendBufferStage2.begin() + common::utility::makeSigned(bytesSent);
-    m_sendBufferStage2.erase(m_sendBufferStage2.begin(), endIt);
-    startSend();
+        // The handler freed space in the meantime. Whoever clears the pause
+        // is the one to resume receiving.
+        if(!m_receivePaused.exchange(false, std::memory_order_relaxed)) {
+            return false;
+        }
+    }
 }
 
-bool Connection::transferReceiveBuffers(std::size_t bytesReceived)
+void Connection::notifyReceivedData()
 {
-    const common::BufferView received{m_receiveBufferStage1.data(),
-                                      bytesReceived};
-    auto buffer = m_receiveBufferStage2.lock();
-    const bool wasEmpty = buffer->empty();
-    buffer->insert(buffer->begin(), received.begin(), received.end());
-    return wasEmpty;
+    m_strand.queue(
+        [self = shared_from_this()]() { self->handleReceivedDataLoop(); });
 }
 
-common::Buffer Connection::extractReceiveBufferStage2()
+void Connection::resizeReceiveBufferStage1(std::size_t bytesReceived)
 {
-    common::Buffer result;
+    if(!m_receiveBufferSizer.recordReceive(bytesReceived)) {
+        return;
+    }
 
-    auto buffer = m_receiveBufferStage2.lock();
-    if(!buffer->empty()) {
-        result = std::move(*buffer);
-        buffer->clear();
+    const std::size_t newSize = m_receiveBufferSizer.getSize();
+    LOG_DEBUG("{}: resized receive buffer from {} to {} bytes",
+              m_remoteEndpoint, m_receiveBufferStage1.size(), newSize);
+
+    // Assign a new buffer rather than resizing so that the memory is released
+    // when shrinking
+    m_receiveBufferStage1 = common::Buffer(newSize);
+}
+
+void Connection::consumeReceiveBufferStage2(std::size_t count)
+{
+    m_receiveBufferStage2.commitRead(count);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_receivePaused.load(std::memory_order_relaxed) &&
+       m_receivePaused.exchange(false, std::memory_order_relaxed)) {
+        asio::post(m_socket.get_executor(), [self = shared_from_this()]() {
+            if(self->continueReceive()) {
+                self->startReceive();
+            }
+        });
     }
+}
 
-    return result;
+bool Connection::insertSendQueueStage1(common::SharedBuffer frame)
+{
+    auto queue = m_sendQueueStage1.lock();
+    queue->frames.emplace_back(std::move(frame));
+    const bool wasSending = queue->sending;
+    queue->sending = true;
+    return !wasSending;
 }
 
-bool Connection::insertSendBufferStage1(common::BufferView data)
+bool Connection::transferSendQueues()
 {
-    auto buffer = m_sendBufferStage1.lock();
-    const bool wasEmpty = buffer->empty();
-    buffer->insert(buffer->begin(), data.begin(), data.end());
-    return wasEmpty;
+    auto queue = m_sendQueueStage1.lock();
+    std::move(queue->frames.begin(), queue->frames.end(),
+              std::back_inserter(m_sendQueueStage2));
+    queue->frames.clear();
+
+    const bool hasFrames = !m_sendQueueStage2.empty();
+    queue->sending = hasFrames;
+    return hasFrames;
 }
 
-void Connection::transferSendBuffers()
+void Connection::consumeSendQueueStage2(std::size_t bytesSent)
 {
-    auto buffer = m_sendBufferStage1.lock();
-    if(!buffer->empty()) {
-        m_sendBufferStage2.insert(m_sendBufferStage2.begin(), buffer->begin(),
-                                  buffer->end());
-        buffer->clear();
+    m_queuedSendBytes.fetch_sub(bytesSent, std::memory_order_relaxed);
+    m_counters.queuedSendBytes.fetch_sub(bytesSent, std::memory_order_relaxed);
+
+    while(!m_sendQueueStage2.empty()) {
+        const std::size_t unsentCount =
+            m_sendQueueStage2.front()->size() - m_sendOffset;
+        if(bytesSent < unsentCount) {
+            m_sendOffset += bytesSent;
+            break;
+        }
+
+        bytesSent -= unsentCount;
+        m_sendQueueStage2.pop_front();
+        m_sendOffset = 0;
     }
 }
 }
@@ -1,37 +1,64 @@
 #pragma once
 
+#include "Counters.hpp"
+#include "ReceiveBufferSizer.hpp"
+
 #include "chat/common/Buffer.hpp"
 #include "chat/common/BufferView.hpp"
-#include "chat/common/FixedBuffer.hpp"
+#include "chat/common/ByteRing.hpp"
+#include "chat/common/Job.hpp"
+#include "chat/common/Result.hpp"
+#include "chat/common/SharedBuffer.hpp"
+#include "chat/common/Strand.hpp"
 #include "chat/common/Synced.hpp"
 #include "chat/common/ThreadPool.hpp"
+#include "chat/messages/IncrementalRequestDeserializer.hpp"
 #include "chat/messages/Request.hpp"
 #include "chat/messages/Response.hpp"
+#include "chat/server/Config.hpp"
 
+#include <asio/awaitable.hpp>
+#include <asio/buffer.hpp>
 #include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <vector>
 
 namespace chat::server
 {
 // Forward declare to break circular dependency between `ConnectionManager.hpp`
 // and `Connection.hpp`
 class ConnectionManager;
+class RequestHandler;
+
+/**
+ * @brief The ID of a connection.
+ *
+ * @details It's unique among the connections that are alive at the same time.
+ */
+using ConnectionId = std::uint64_t;
 
 /**
  * @brief A communication channel to the client.
  *
  * @details A connection is the middleman between the client and server. It
  * manages the I/O operations to receive data from the client and send data to
- * the client. The received data is passed to a handler, which processes the
- * data and sends data back to the client through the connection.
+ * the client. The received data is deserialized into requests, which are passed
+ * to a request handler. The responses from the request handler are serialized
+ * and sent back to the client through the connection.
  *
- * The connection utilizes a 2-stage buffer system for receiving, handling, and
- * sending data. The following is a diagram to visualize the flow of data:
+ * The connection utilizes a 2-stage system for receiving, handling, and sending
+ * data. The following is a diagram to visualize the flow of data:
  *            +---------+      +---------+
  *            | stage 1 |      | stage 2 |
  *      +---> | receive | ---> | receive | -----+
- *      |     | buffer  |      | buffer  |      |
+ *      |     | buffer  |      | ring    |      |
  *      |     +---------+      +---------+      v
  * +--------+                              +---------+
  * | socket |                              | handler |
@@ -39,20 +66,68 @@ class ConnectionManager;
  *      ^     +---------+      +---------+      |
  *      |     | stage 2 |      | stage 1 |      |
  *      +---- | send    | <--- | send    | <----+
- *            | buffer  |      | buffer  |
+ *            | queue   |      | queue   |
  *            +---------+      +---------+
  *
- * Transferring data between stage 1 and stage 2 buffers is done in a
- * thread-safe manner since the socket and handler could be running at the same
- * time.
+ * Transferring data between stage 1 and stage 2 is done in a thread-safe
+ * manner since the socket and handler could be running at the same time.
+ *
+ * The stage 2 receive ring is a lock-free single-producer/single-consumer ring,
+ * so handing received data to the handler doesn't take a lock. The socket is
+ * the only producer, and the handler is the only consumer since the jobs that
+ * handle the connection's received data run on the connection's strand. When
+ * the ring is full, the connection stops receiving and keeps the rest of the
+ * data in the stage 1 receive buffer. The handler resumes receiving once it has
+ * freed space in the ring.
+ *
+ * The stage 1 receive buffer adapts its size to the rate the client sends data
+ * at. It grows when a receive fills it, so a burst of data takes fewer receive
+ * operations, and it shrinks to fit once several receives in a row have used
+ * at most half of it. Once a receive doesn't fill the buffer, the client has
+ * caught up, so the next receive first waits for data without using the
+ * buffer. If no data arrives within the idle timeout of the server's
+ * @c Config, the buffer shrinks to the minimum, so an idle connection doesn't
+ * hold onto a large buffer. The size stays within the limits set by the
+ * server's @c Config.
+ *
+ * Complete requests in the received data are deserialized in place. Only the
+ * bytes of an incomplete request at the end of the received data are copied
+ * and kept until the rest of the request is received.
+ *
+ * A client can send many requests without waiting for their responses. When
+ * multiple requests are received at once, the ones that can be handled
+ * concurrently are queued into the thread pool and handled in parallel, so
+ * their responses can be sent in a different order than the requests were
+ * received. Each response carries the correlation ID of its request, which the
+ * client uses to match them up.
+ *
+ * Data to send is queued as frames, which are immutable buffers with shared
+ * ownership. Transferring frames between the send queues only moves the
+ * pointers to the frames. The frames in the stage 2 send queue are sent with a
+ * single vectored send operation, which lets the socket read the frames in
+ * place rather than having them copied into one contiguous buffer.
+ *
+ * The number of bytes waiting to be sent is bounded by water marks. Once it
+ * reaches the high water mark of the server's @c Config, the connection stops
+ * receiving, so a client that doesn't read its responses can't make the server
+ * hold an unbounded number of bytes for it. The connection resumes receiving
+ * once the number of bytes waiting to be sent falls to the low water mark.
+ *
+ * Receiving and sending are each done by a coroutine running on the socket's
+ * executor, which loops over its asynchronous operation until it has nothing
+ * left to do. Awaiting an operation suspends the coroutine in place, so a loop
+ * doesn't create a completion handler per operation. When receiving is paused
+ * or blocked, the receive coroutine returns, and a new one is spawned once
+ * receiving resumes. Likewise, the send coroutine returns once the send queues
+ * are empty, and the next frame to send spawns a new one.
  *
  * The lifetime of a connection is managed through `std::shared_ptr`s and
  * `std::enable_shared_from_this`. To use `shared_from_this()`, an
  * `std::shared_ptr` must already exist before it can be called, which is done
  * by the connection manager upon creating the connection object when accepted
- * by the listener. The result of `shared_from_this()` is passed to thread pool
- * jobs and the completion tokens to prevent destroying the connection while
- * one of them is outstanding.
+ * by the listener. The result of `shared_from_this()` is passed to strand jobs
+ * and the coroutines to prevent destroying the connection while one of them is
+ * outstanding.
  */
 class Connection : public std::enable_shared_from_this<Connection>
 {
@@ -61,13 +136,42 @@ public:
      * @brief Construct a connection.
      *
      * @param socket The socket used to communicate with the client.
+     * @param id The ID given to the connection by its manager.
      * @param connectionManager The manager for this connection.
+     * @param requestHandler The handler for received requests.
      * @param threadPool The thread pool to queue work into to handle received
      * data.
+     * @param config The server settings.
+     * @param counters The server counters to update.
      */
-    Connection(asio::ip::tcp::socket&& socket,
+    Connection(asio::ip::tcp::socket&& socket, ConnectionId id,
                ConnectionManager& connectionManager,
-               common::ThreadPool& threadPool);
+               RequestHandler& requestHandler, common::ThreadPool& threadPool,
+               const Config& config, Counters& counters);
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    Connection(const Connection& other) = delete;
+    Connection& operator=(const Connection& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    Connection(Connection&& other) = delete;
+    Connection& operator=(Connection&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the connection.
+     *
+     * @details The bytes that were still waiting to be sent are removed from
+     * the server counters.
+     */
+    ~Connection();
 
     /**
      * @brief Start the connection.
@@ -84,6 +188,13 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Get the ID of the connection.
+     *
+     * @return The ID of the connection.
+     */
+    [[nodiscard]] ConnectionId getId() const;
+
 private:
     /**
      * @brief Set the remote endpoint.
@@ -91,128 +202,251 @@ private:
     void setRemoteEndpoint();
 
     /**
-     * @brief Start the asynchronous receive operation.
-     *
-     * @details The received data is placed into the stage 1 receive buffer.
+     * @brief Spawn the receive coroutine on the socket's executor.
      */
     void startReceive();
 
     /**
-     * @brief The completion token for the asynchronous receive operation.
+     * @brief Receive data until receiving is paused, blocked, or fails.
+     *
+     * @details The received data is placed into the stage 1 receive buffer and
+     * then transferred into the stage 2 receive ring. If an error is
+     * indicated, the connection is stopped.
+     *
+     * @return The coroutine.
+     */
+    asio::awaitable<void> receiveLoop();
+
+    /**
+     * @brief Wait until there is data to receive.
      *
-     * @details If an error is indicated, the connection is stopped.
+     * @details The stage 1 receive buffer isn't used while waiting, so it's
+     * shrunk to the minimum size if the wait lasts longer than the idle
+     * timeout. If an error is indicated, the connection is stopped.
      *
-     * The data in the stage 1 receive buffer is transferred into the stage 2
-     * receive buffer. If a job isn't currently running or the current job is
-     * about to stop running, a new job is queued to handle the data in the
-     * stage 2 receive buffer.
+     * @return The coroutine, which returns true if there is data to receive;
+     * false if the wait failed.
+     */
+    asio::awaitable<bool> waitForData();
+
+    /**
+     * @brief Shrink the stage 1 receive buffer if the connection is still
+     * waiting for data.
+     */
+    void shrinkIdleReceiveBuffer();
+
+    /**
+     * @brief Continue transferring received data.
      *
-     * The asynchronous operation is started again.
+     * @details The data in the stage 1 receive buffer that hasn't been
+     * transferred yet is transferred into the stage 2 receive ring. If all of
+     * it is transferred, the stage 1 receive buffer is resized for the next
+     * receive. Otherwise, receiving is paused until the handler frees space in
+     * the stage 2 receive ring.
      *
-     * @param ec The error code from the asynchronous operation.
-     * @param bytesReceived The number of bytes received.
+     * If the number of bytes waiting to be sent has reached the high water
+     * mark, receiving is blocked until the number of bytes falls to the low
+     * water mark.
+     *
+     * @return True if receiving can continue; false if it's paused or blocked.
      */
-    void receiveToken(asio::error_code ec, std::size_t bytesReceived);
+    bool continueReceive();
 
     /**
      * @brief Handle received data until there is no more.
      *
-     * @details The data in the stage 2 receive buffer is extracted from the
-     * buffer and is handled. This repeats until there is no more data to
-     * handle.
+     * @details The data in the stage 2 receive ring is handled until the ring
+     * is empty. This runs on the connection's strand, so it never runs at the
+     * same time as itself.
      */
     void handleReceivedDataLoop();
 
     /**
      * @brief Handle received data.
      *
-     * @details The received data is consumed. Depending on the logic, data may
-     * be added to the stage 1 send buffer to be sent to the client.
+     * @details All complete requests in the received data are deserialized in
+     * one pass and are then handled, and their responses are sent to the
+     * client. Concurrent high priority requests, such as pings, are always
+     * queued into the thread pool as a batch. If there are multiple requests,
+     * the other concurrent ones are queued as another batch, and the rest are
+     * then handled in order on the current thread. The bytes of an incomplete
+     * request at the end of the data are kept to be handled with the next
+     * received data.
+     *
+     * The data is removed from the stage 2 receive ring before the requests are
+     * handled, so the socket can keep receiving while they are.
      *
-     * @param data The received data.
+     * @param data The received data, read from the stage 2 receive ring.
      */
-    void handleReceivedData(common::Buffer data);
+    void handleReceivedData(const common::BufferView& data);
 
     /**
-     * @brief Send data to the client.
+     * @brief Queue the received requests of a priority that can be handled
+     * concurrently into the thread pool as a single batch.
      *
-     * @details The data is inserted into the stage 1 send buffer. If an
-     * asynchronous send operation isn't currently running, it is started.
+     * @details The queued requests are moved out of their results.
      *
-     * @param data The data to send.
+     * @param priority The priority of the requests to queue.
      */
-    void send(common::BufferView data);
+    void queueConcurrentRequests(common::ThreadPool::Priority priority);
 
     /**
-     * @brief Start the asynchronous send operation.
+     * @brief Handle a request.
      *
-     * @details The data from the stage 1 send buffer is transferred into the
-     * stage 2 send buffer. If there is data in the stage 2 send buffer, the
-     * asynchronous send operation is started using the stage 2 send buffer.
+     * @details The response to the request is given the request's correlation
+     * ID and is sent to the client. This can be called from multiple threads
+     * at the same time.
+     *
+     * @param request The request to handle.
+     */
+    void handleRequest(const messages::Request& request);
+
+    /**
+     * @brief Send a frame to the client.
+     *
+     * @details The frame is inserted into the stage 1 send queue. If the send
+     * coroutine isn't currently running, one is spawned on the socket's
+     * executor.
+     *
+     * @param frame The frame to send.
      */
-    void startSend();
+    void send(common::SharedBuffer frame);
 
     /**
-     * @brief The completion token for the asynchronous send operation.
+     * @brief Send frames until the send queues are empty or sending fails.
+     *
+     * @details The frames from the stage 1 send queue are transferred into the
+     * stage 2 send queue, and the unsent bytes of the frames in the stage 2
+     * send queue are sent. The frames that have been completely sent are
+     * removed from the queue. If an error is indicated, the connection is
+     * stopped.
+     *
+     * If receiving is blocked and the number of bytes waiting to be sent has
+     * fallen to the low water mark, receiving is started again.
      *
-     * @details If an error is indicated, the connection is stopped.
+     * @return The coroutine.
+     */
+    asio::awaitable<void> sendLoop();
+
+    /**
+     * @brief Transfer the untransferred data in the stage 1 receive buffer into
+     * the stage 2 receive ring.
      *
-     * The bytes sent in the stage 2 send buffer are deleted from the buffer.
+     * @details The handler is notified of every transfer. If the ring fills up
+     * before all the data is transferred, receiving is marked as paused, and
+     * the handler resumes it once it frees space in the ring.
      *
-     * The asynchronous operation is started again.
+     * @return True if all the data is transferred; false if receiving is
+     * paused.
+     */
+    bool transferReceiveBuffers();
+
+    /**
+     * @brief Notify the handler that data has been transferred into the stage
+     * 2 receive ring.
      *
-     * @param ec The error code from the asynchronous operation.
-     * @param bytesSent The number of bytes sent.
+     * @details A job to handle the received data is queued into the
+     * connection's strand. Every transfer queues a job so that none go
+     * unhandled, and a job that finds the ring empty because an earlier job
+     * handled its data returns immediately.
      */
-    void sendToken(asio::error_code ec, std::size_t bytesSent);
+    void notifyReceivedData();
 
     /**
-     * @brief Transfer the data in the receive buffers from stage 1 to stage 2.
+     * @brief Resize the stage 1 receive buffer based on the last receive.
      *
-     * @details The receive data job stops executing once there is no more data
-     * in the stage 2 receive buffer. The return value of this function is used
-     * to determine if a new job should be queued.
+     * @details The new size is decided by the receive buffer sizer, which only
+     * changes it when a receive fills the buffer or several in a row use at
+     * most half of it.
+     *
+     * @param bytesReceived The number of bytes of the last receive.
+     */
+    void resizeReceiveBufferStage1(std::size_t bytesReceived);
+
+    /**
+     * @brief Remove handled data from the stage 2 receive ring.
      *
-     * @param bytesReceived The number of bytes in the stage 1 receive buffer,
-     * starting from the start of the buffer, to transfer into the stage 2
-     * receive buffer.
+     * @details If receiving is paused because the ring was full, it is resumed
+     * on the socket's executor.
      *
-     * @return True if the stage 2 receive buffer was empty before the transfer;
-     * false otherwise.
+     * @param count The number of bytes to remove, starting from the read
+     * position of the ring.
      */
-    bool transferReceiveBuffers(std::size_t bytesReceived);
+    void consumeReceiveBufferStage2(std::size_t count);
 
     /**
-     * @brief Extract all the data from the stage 2 receive buffer.
+     * @brief Insert a frame into the stage 1 send queue.
      *
-     * @return The data from the stage 2 receive buffer.
+     * @param frame The frame to insert into the stage 1 send queue.
+     *
+     * @return True if a send operation needs to be started; false otherwise.
      */
-    common::Buffer extractReceiveBufferStage2();
+    bool insertSendQueueStage1(common::SharedBuffer frame);
 
     /**
-     * @brief Insert data into the stage 1 send buffer.
+     * @brief Transfer the frames in the send queues from stage 1 to stage 2.
+     *
+     * @details If there are no frames to send after the transfer, the send
+     * operation is marked as finished so that the next inserted frame starts a
+     * new send operation.
      *
-     * @param data The data to insert into the stage 1 send buffer.
+     * @return True if there are frames in the stage 2 send queue; false
+     * otherwise.
+     */
+    bool transferSendQueues();
+
+    /**
+     * @brief Remove sent bytes from the stage 2 send queue.
      *
-     * @return True if the stage 1 send buffer was empty before the insertion;
-     * false otherwise.
+     * @param bytesSent The number of bytes sent, starting from the first unsent
+     * byte of the first frame.
      */
-    bool insertSendBufferStage1(common::BufferView data);
+    void consumeSendQueueStage2(std::size_t bytesSent);
 
     /**
-     * @brief Transfer the data in the send buffers from stage 1 to stage 2.
+     * @brief The frames waiting to be transferred to the socket.
+     *
+     * @details The flag indicating whether a send operation is running is kept
+     * with the frames so that both are updated under the same lock. Only the
+     * running send operation touches the stage 2 send queue.
      */
-    void transferSendBuffers();
+    struct SendQueueStage1
+    {
+        std::deque<common::SharedBuffer> frames;
+        bool sending = false;
+    };
 
-    static constexpr std::size_t receiveBufferStage1Size = 256;
+    // Matches the number of buffers Asio passes to a single system call
+    static constexpr std::size_t maxSendBufferCount = 64;
 
     asio::ip::tcp::socket m_socket;
+    ConnectionId m_id;
     ConnectionManager& m_connectionManager;
+    RequestHandler& m_requestHandler;
     common::ThreadPool& m_threadPool;
+    const Config& m_config;
+    Counters& m_counters;
     asio::ip::tcp::endpoint m_remoteEndpoint;
-    common::FixedBuffer<receiveBufferStage1Size> m_receiveBufferStage1;
-    common::Synced<common::Buffer> m_receiveBufferStage2;
-    common::Synced<common::Buffer> m_sendBufferStage1;
-    common::Buffer m_sendBufferStage2;
+    ReceiveBufferSizer m_receiveBufferSizer;
+    common::Buffer m_receiveBufferStage1;
+    common::BufferView m_untransferredData;
+    std::size_t m_lastReceiveSize;
+    asio::steady_timer m_receiveIdleTimer;
+    bool m_waitingForData;
+    common::ByteRing m_receiveBufferStage2;
+    common::Strand m_strand;
+    std::atomic_bool m_receivePaused;
+    bool m_receiveBlocked;
+    messages::IncrementalRequestDeserializer m_deserializer;
+    std::vector<common::Result<std::unique_ptr<messages::Request>,
+                               messages::IncrementalRequestDeserializer::
+                                   FailureReason>>
+        m_requests;
+    std::vector<common::Job> m_concurrentJobs;
+    common::Synced<SendQueueStage1> m_sendQueueStage1;
+    std::deque<common::SharedBuffer> m_sendQueueStage2;
+    std::size_t m_sendOffset;
+    std::atomic_size_t m_queuedSendBytes;
+    std::array<asio::const_buffer, maxSendBufferCount> m_sendBuffers;
 };
 }
@@ -1,40 +1,112 @@
 #include "ConnectionManager.hpp"
 
 #include "Connection.hpp"
+#include "Counters.hpp"
 
 #include "chat/common/ThreadPool.hpp"
+#include "chat/server/Config.hpp"
 
 #include <asio/ip/tcp.hpp>
 
+#include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace chat::server
 {
-ConnectionManager::ConnectionManager(common::ThreadPool& threadPool)
+ConnectionManager::ConnectionManager(common::ThreadPool& threadPool,
+                                     const Config& config, Counters& counters)
   : m_threadPool{threadPool},
+    m_config{config},
+    m_counters{counters},
     m_requestHandler{},
     m_connections{}
 {}
 
 void ConnectionManager::start(asio::ip::tcp::socket&& socket)
 {
-    auto connection =
-        std::make_shared<Connection>(std::move(socket), *this, m_threadPool);
+    // The connection's ID is the key of its slot, so the slot is reserved
+    // first. The connection is created after the lock is released so that it
+    // doesn't hold up the threads looking up connections.
+    const auto id = m_connections.lock()->insert(nullptr);
+    std::shared_ptr<Connection> connection;
+    try {
+        connection = std::make_shared<Connection>(
+            std::move(socket), id, *this, m_requestHandler, m_threadPool,
+            m_config, m_counters);
+    } catch(...) {
+        m_connections.lock()->erase(id);
+        throw;
+    }
+
+    {
+        auto connections = m_connections.lock();
+        auto* slot = connections->find(id);
+
+        // The slot is gone if every connection was stopped in the meantime,
+        // in which case the connection is never started
+        if(slot == nullptr) {
+            return;
+        }
+
+        *slot = connection;
+    }
+
     connection->start();
-    m_connections.emplace_back(std::move(connection));
 }
 
-void ConnectionManager::remove(const Connection& connection)
+void ConnectionManager::remove(ConnectionId id)
+{
+    // The connection is destroyed after the lock is released since its
+    // destructor doesn't need to hold up other threads
+    std::shared_ptr<Connection> connection;
+    {
+        auto connections = m_connections.lock();
+        auto* slot = connections->find(id);
+        if(slot == nullptr) {
+            return;
+        }
+
+        connection = std::move(*slot);
+        connections->erase(id);
+    }
+}
+
+std::shared_ptr<Connection> ConnectionManager::find(ConnectionId id) const
+{
+    auto connections = m_connections.lock();
+    const auto* slot = connections->find(id);
+    return slot != nullptr ? *slot : nullptr;
+}
+
+std::size_t ConnectionManager::getCount() const
 {
-    m_connections.remove_if(
-        [&connection](const auto& elem) { return elem.get() == &connection; });
+    auto connections = m_connections.lock();
+    return connections->size();
 }
 
 void ConnectionManager::stopAll()
 {
-    for(auto& connection : m_connections) {
-        connection->stop();
+    // Stopping a connection removes it from the manager, so the connections
+    // are taken out first rather than stopped while the slot map is iterated
+    std::vector<std::shared_ptr<Connection>> stopping;
+    {
+        auto connections = m_connections.lock();
+        stopping.reserve(connections->size());
+        connections->forEach(
+            [&stopping]([[maybe_unused]] ConnectionId id,
+                        std::shared_ptr<Connection>& connection) {
+                stopping.emplace_back(std::move(connection));
+            });
+        connections->clear();
+    }
+
+    // A connection that is still being created only has its slot reserved
+    for(auto& connection : stopping) {
+        if(connection != nullptr) {
+            connection->stop();
+        }
     }
 }
 }
@@ -1,14 +1,19 @@
 #pragma once
 
 #include "Connection.hpp"
+#include "Counters.hpp"
 #include "RequestHandler.hpp"
 
+#include "chat/common/SlotMap.hpp"
+#include "chat/common/SharedSynced.hpp"
 #include "chat/common/ThreadPool.hpp"
+#include "chat/server/Config.hpp"
 
 #include <asio/ip/tcp.hpp>
 
-#include <list>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 
 namespace chat::server
 {
@@ -17,7 +22,11 @@ namespace chat::server
  *
  * @details A connection manager simply knows about all connections at any given
  * moment. It is the one that creates and destroys them. All connections are
- * kept in an internal list.
+ * kept in an internal slot map, which gives each connection an ID that can be
+ * used to find it in constant time.
+ *
+ * A single connection manager is shared by all the shards of the server, so it
+ * is safe to use from multiple threads.
  */
 class ConnectionManager
 {
@@ -26,12 +35,18 @@ public:
      * @brief Construct a connection manager.
      *
      * @param threadPool The thread pool to pass to connections.
+     * @param config The server settings to pass to connections.
+     * @param counters The server counters to pass to connections.
      */
-    explicit ConnectionManager(common::ThreadPool& threadPool);
+    ConnectionManager(common::ThreadPool& threadPool, const Config& config,
+                      Counters& counters);
 
     /**
      * @brief Create and start a new connection.
      *
+     * @details If creating the connection throws, the manager is left as it
+     * was before.
+     *
      * @param socket The socket for the connection.
      */
     void start(asio::ip::tcp::socket&& socket);
@@ -39,9 +54,29 @@ public:
     /**
      * @brief Remove connection from the manager.
      *
-     * @param connection The connection to remove.
+     * @details Removing a connection that has already been removed has no
+     * effect.
+     *
+     * @param id The ID of the connection to remove.
      */
-    void remove(const Connection& connection);
+    void remove(ConnectionId id);
+
+    /**
+     * @brief Find a connection.
+     *
+     * @param id The ID of the connection.
+     *
+     * @return The connection if it has been created and hasn't been removed;
+     * otherwise, `nullptr`.
+     */
+    [[nodiscard]] std::shared_ptr<Connection> find(ConnectionId id) const;
+
+    /**
+     * @brief Get the number of connections.
+     *
+     * @return The number of connections.
+     */
+    [[nodiscard]] std::size_t getCount() const;
 
     /**
      * @brief Stop and remove all connections.
@@ -49,8 +84,15 @@ public:
     void stopAll();
 
 private:
+    using Connections = common::SlotMap<std::shared_ptr<Connection>>;
+    static_assert(std::is_same_v<Connections::Key, ConnectionId>,
+                  "Connection IDs must be the keys of the slot map");
+
     common::ThreadPool& m_threadPool;
+    const Config& m_config;
+    Counters& m_counters;
     RequestHandler m_requestHandler;
-    std::list<std::shared_ptr<Connection>> m_connections;
+    // Connections are looked up far more often than they are added or removed
+    common::SharedSynced<Connections> m_connections;
 };
 }
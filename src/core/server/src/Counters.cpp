@@ -0,0 +1,18 @@
+#include "Counters.hpp"
+
+#include "chat/server/Stats.hpp"
+
+#include <atomic>
+
+namespace chat::server
+{
+Stats Counters::getStats() const
+{
+    Stats stats;
+    stats.queuedSendBytes = queuedSendBytes.load(std::memory_order_relaxed);
+    stats.sendBlockedConnectionCount =
+        sendBlockedConnectionCount.load(std::memory_order_relaxed);
+    stats.sendBlockCount = sendBlockCount.load(std::memory_order_relaxed);
+    return stats;
+}
+}
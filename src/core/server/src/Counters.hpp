@@ -0,0 +1,31 @@
+#pragma once
+
+#include "chat/server/Stats.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace chat::server
+{
+/**
+ * @brief The counters behind a @c Stats snapshot.
+ *
+ * @details The counters are shared by all connections of a server and are
+ * updated concurrently, so they are atomic. They are only used for reporting,
+ * so they don't order any other memory operations.
+ */
+struct Counters
+{
+    /**
+     * @brief Take a snapshot of the counters.
+     *
+     * @return A snapshot of the counters.
+     */
+    [[nodiscard]] Stats getStats() const;
+
+    std::atomic_size_t queuedSendBytes = 0;
+    std::atomic_size_t sendBlockedConnectionCount = 0;
+    std::atomic_uint64_t sendBlockCount = 0;
+};
+}
@@ -9,16 +9,78 @@
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
 
+#include <sys/socket.h>
+
+#include <cstddef>
 #include <utility>
 
 namespace chat::server
 {
+namespace
+{
+/**
+ * @brief The socket option to let multiple sockets bind to the same port.
+ *
+ * @details Asio doesn't provide this option since it isn't portable to all
+ * platforms, so it's defined here the same way as the options of
+ * `asio::socket_base`, by meeting the requirements of a settable socket
+ * option.
+ */
+class ReusePort
+{
+public:
+    explicit ReusePort(bool enabled)
+      : m_value{enabled ? 1 : 0}
+    {}
+
+    template<typename Protocol>
+    [[nodiscard]] int level([[maybe_unused]] const Protocol& protocol) const
+    {
+        return SOL_SOCKET;
+    }
+
+    template<typename Protocol>
+    [[nodiscard]] int name([[maybe_unused]] const Protocol& protocol) const
+    {
+        return SO_REUSEPORT;
+    }
+
+    template<typename Protocol>
+    [[nodiscard]] const int* data(
+        [[maybe_unused]] const Protocol& protocol) const
+    {
+        return &m_value;
+    }
+
+    template<typename Protocol>
+    [[nodiscard]] std::size_t size(
+        [[maybe_unused]] const Protocol& protocol) const
+    {
+        return sizeof(m_value);
+    }
+
+private:
+    int m_value;
+};
+}
+
 Listener::Listener(asio::io_context& ioContext,
                    const asio::ip::tcp::endpoint& endpoint,
-                   ConnectionManager& connectionManager)
-  : m_acceptor{ioContext, endpoint},
+                   ConnectionManager& connectionManager, bool reusePort)
+  : m_acceptor{ioContext},
     m_connectionManager{connectionManager}
-{}
+{
+    // Same steps as constructing the acceptor with the endpoint, but with the
+    // option to reuse the port set before binding
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.set_option(asio::ip::tcp::acceptor::reuse_address{true});
+    if(reusePort) {
+        m_acceptor.set_option(ReusePort{true});
+    }
+
+    m_acceptor.bind(endpoint);
+    m_acceptor.listen();
+}
 
 void Listener::start()
 {
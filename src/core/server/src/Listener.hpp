@@ -19,10 +19,12 @@ public:
      * @param ioContext The execution context for I/O.
      * @param endpoint The endpoint to listen for connections on.
      * @param connectionManager The manager to create connections from.
+     * @param reusePort Whether other listeners can bind to the same endpoint
+     * with @c SO_REUSEPORT.
      */
     Listener(asio::io_context& ioContext,
              const asio::ip::tcp::endpoint& endpoint,
-             ConnectionManager& connectionManager);
+             ConnectionManager& connectionManager, bool reusePort = false);
 
     /**
      * @brief Start listening for connections.
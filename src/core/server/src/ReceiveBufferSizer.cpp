@@ -0,0 +1,71 @@
+#include "ReceiveBufferSizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+
+namespace chat::server
+{
+ReceiveBufferSizer::ReceiveBufferSizer(std::size_t minSize,
+                                       std::size_t maxSize)
+  : m_minSize{minSize},
+    m_maxSize{maxSize},
+    m_size{minSize},
+    m_smallReceiveCount{0},
+    m_largestSmallReceive{0}
+{
+    if(m_minSize < 1) {
+        throw std::invalid_argument{"min size must be greater than 0"};
+    }
+
+    if(m_minSize > m_maxSize) {
+        throw std::invalid_argument{
+            "min size must not be greater than max size"};
+    }
+}
+
+std::size_t ReceiveBufferSizer::getSize() const
+{
+    return m_size;
+}
+
+std::size_t ReceiveBufferSizer::getMinSize() const
+{
+    return m_minSize;
+}
+
+bool ReceiveBufferSizer::recordReceive(std::size_t bytesReceived)
+{
+    const std::size_t size = m_size;
+    if(bytesReceived >= m_size) {
+        m_smallReceiveCount = 0;
+        m_largestSmallReceive = 0;
+        m_size = std::min(m_size * 2, m_maxSize);
+    } else if(bytesReceived <= m_size / 2) {
+        m_smallReceiveCount++;
+        m_largestSmallReceive = std::max(m_largestSmallReceive, bytesReceived);
+        if(m_smallReceiveCount >= shrinkReceiveCount) {
+            m_size = std::clamp(std::bit_ceil(m_largestSmallReceive), m_minSize,
+                                m_size);
+            m_smallReceiveCount = 0;
+            m_largestSmallReceive = 0;
+        }
+    } else {
+        // The buffer fits the receive without wasting more than half of it
+        m_smallReceiveCount = 0;
+        m_largestSmallReceive = 0;
+    }
+
+    return m_size != size;
+}
+
+bool ReceiveBufferSizer::shrinkForIdle()
+{
+    const std::size_t size = m_size;
+    m_size = m_minSize;
+    m_smallReceiveCount = 0;
+    m_largestSmallReceive = 0;
+    return m_size != size;
+}
+}
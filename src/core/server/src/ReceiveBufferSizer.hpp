@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+namespace chat::server
+{
+/**
+ * @brief Decides the size of a connection's receive buffer.
+ *
+ * @details The buffer doubles when a receive fills it, since there is likely
+ * more data waiting to be received. It only shrinks once several receives in a
+ * row have used at most half of it, and then only to fit the largest of them,
+ * so a client whose receives vary in size doesn't make the buffer be
+ * reallocated after every receive. A connection that goes idle is shrunk to the
+ * minimum separately, since an idle connection doesn't complete any receives.
+ *
+ * The size stays between a minimum and maximum size.
+ */
+class ReceiveBufferSizer
+{
+public:
+    /**
+     * @brief Construct a sizer, starting at the minimum size.
+     *
+     * @param minSize The minimum size of the buffer.
+     * @param maxSize The maximum size of the buffer.
+     *
+     * @throws std::invalid_argument If the minimum size is 0 or greater than
+     * the maximum size.
+     */
+    ReceiveBufferSizer(std::size_t minSize, std::size_t maxSize);
+
+    /**
+     * @brief Get the size the buffer should be.
+     *
+     * @return The size.
+     */
+    [[nodiscard]] std::size_t getSize() const;
+
+    /**
+     * @brief Get the minimum size of the buffer.
+     *
+     * @return The minimum size.
+     */
+    [[nodiscard]] std::size_t getMinSize() const;
+
+    /**
+     * @brief Record a receive into a buffer of the current size.
+     *
+     * @param bytesReceived The number of bytes received.
+     *
+     * @return True if the size changed; otherwise, false.
+     */
+    bool recordReceive(std::size_t bytesReceived);
+
+    /**
+     * @brief Shrink to the minimum size since the connection is idle.
+     *
+     * @return True if the size changed; otherwise, false.
+     */
+    bool shrinkForIdle();
+
+private:
+    // The number of receives in a row that have to use at most half of the
+    // buffer before it shrinks
+    static constexpr std::size_t shrinkReceiveCount = 8;
+
+    std::size_t m_minSize;
+    std::size_t m_maxSize;
+    std::size_t m_size;
+    std::size_t m_smallReceiveCount;
+    std::size_t m_largestSmallReceive;
+};
+}
@@ -1,6 +1,7 @@
 #include "RequestHandler.hpp"
 
 #include "chat/common/Logging.hpp"
+#include "chat/common/ThreadPool.hpp"
 #include "chat/messages/Request.hpp"
 #include "chat/messages/Response.hpp"
 #include "chat/messages/request/Ping.hpp"
@@ -39,6 +40,31 @@ std::unique_ptr<messages::Response> RequestHandler::handle(
     return response;
 }
 
+bool RequestHandler::isConcurrent(const messages::Request& request) const
+{
+    bool concurrent = false;
+    switch(request.getType()) {
+    case messages::Request::Type::Ping:
+        concurrent = true;
+        break;
+    }
+
+    return concurrent;
+}
+
+common::ThreadPool::Priority RequestHandler::getPriority(
+    const messages::Request& request) const
+{
+    auto priority = common::ThreadPool::Priority::Normal;
+    switch(request.getType()) {
+    case messages::Request::Type::Ping:
+        priority = common::ThreadPool::Priority::High;
+        break;
+    }
+
+    return priority;
+}
+
 std::unique_ptr<messages::Response> RequestHandler::handlePing(
     [[maybe_unused]] const messages::Ping& request)
 {
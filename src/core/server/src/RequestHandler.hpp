@@ -1,5 +1,6 @@
 #pragma once
 
+#include "chat/common/ThreadPool.hpp"
 #include "chat/messages/Request.hpp"
 #include "chat/messages/Response.hpp"
 #include "chat/messages/request/Ping.hpp"
@@ -51,6 +52,33 @@ public:
     std::unique_ptr<messages::Response> handle(
         const messages::Request& request);
 
+    /**
+     * @brief Check if a request can be handled at the same time as other
+     * requests from the same client.
+     *
+     * @details A request that doesn't depend on the requests sent before it
+     * can be handled on any thread, in any order relative to them.
+     *
+     * @param request The request to check.
+     *
+     * @return True if the request can be handled concurrently; otherwise,
+     * false.
+     */
+    [[nodiscard]] bool isConcurrent(const messages::Request& request) const;
+
+    /**
+     * @brief Get the priority to handle a request with.
+     *
+     * @details Control requests, such as pings that measure liveness, are
+     * handled with a high priority so that they don't wait behind bulk work.
+     *
+     * @param request The request to check.
+     *
+     * @return The priority of the request.
+     */
+    [[nodiscard]] common::ThreadPool::Priority getPriority(
+        const messages::Request& request) const;
+
 private:
     /**
      * @brief Handle a ping request.
@@ -3,6 +3,8 @@
 #include "ServerImpl.hpp"
 
 #include "chat/common/Port.hpp"
+#include "chat/server/Config.hpp"
+#include "chat/server/Stats.hpp"
 
 #include <cstddef>
 #include <memory>
@@ -10,8 +12,9 @@
 namespace chat::server
 {
 
-Server::Server(common::Port port, std::size_t maxThreadCount)
-  : m_impl{std::make_unique<Impl>(port, maxThreadCount)}
+Server::Server(common::Port port, std::size_t maxThreadCount,
+               const Config& config)
+  : m_impl{std::make_unique<Impl>(port, maxThreadCount, config)}
 {}
 
 Server::~Server() = default;
@@ -26,4 +29,9 @@ void Server::stop()
     m_impl->stop();
 }
 
+Stats Server::getStats() const
+{
+    return m_impl->getStats();
+}
+
 }
@@ -2,13 +2,20 @@
 
 #include "chat/common/Logging.hpp"
 #include "chat/common/Port.hpp"
+#include "chat/common/ThreadPool.hpp"
+#include "chat/common/affinity.hpp"
 #include "chat/common/utility.hpp"
+#include "chat/server/Config.hpp"
 #include "chat/server/Server.hpp"
+#include "chat/server/Stats.hpp"
 
 #include <asio/ip/tcp.hpp>
 
 #include <cstddef>
+#include <memory>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace chat::server
 {
@@ -19,18 +26,119 @@ auto createListenerEndpoint(common::Port port)
     return asio::ip::tcp::endpoint{asio::ip::tcp::v4(),
                                    common::utility::toUnderlying(port)};
 }
+
+/**
+ * @brief Get the thread pool's idle policy for an idle profile.
+ *
+ * @param profile The idle profile.
+ *
+ * @return The idle policy.
+ */
+common::ThreadPool::IdlePolicy getIdlePolicy(IdleProfile profile)
+{
+    auto policy = common::ThreadPool::IdlePolicy::powerSaving();
+    switch(profile) {
+    case IdleProfile::PowerSaving:
+        break;
+    case IdleProfile::LowLatency:
+        policy = common::ThreadPool::IdlePolicy::lowLatency();
+        break;
+    }
+
+    return policy;
 }
 
-Server::Impl::Impl(common::Port port, std::size_t maxThreadCount)
-  : m_running{false},
-    m_threadPool{maxThreadCount},
-    m_connectionManager{m_threadPool},
-    m_ioContext{},
-    m_listener{m_ioContext, createListenerEndpoint(port), m_connectionManager}
+/**
+ * @brief Get the thread pool's sizing policy for a server.
+ *
+ * @details The thread counts are validated here, since the thread pool is
+ * constructed before the server's constructor body runs.
+ *
+ * @param maxThreadCount The number of threads for the server to use.
+ * @param config The tunable settings of the server.
+ *
+ * @return The sizing policy.
+ *
+ * @throws std::invalid_argument If the max thread count is 0, or if the min
+ * worker thread count is 0 or greater than the max thread count.
+ */
+common::ThreadPool::SizingPolicy getSizingPolicy(std::size_t maxThreadCount,
+                                                 const Config& config)
 {
     if(maxThreadCount < 1) {
         throw std::invalid_argument{"max thread count must greater than 0"};
     }
+
+    if(config.minWorkerThreadCount.has_value() &&
+       (config.minWorkerThreadCount.value() < 1 ||
+        config.minWorkerThreadCount.value() > maxThreadCount)) {
+        throw std::invalid_argument{
+            "min worker thread count must be greater than 0 and not greater "
+            "than max thread count"};
+    }
+
+    if(!config.minWorkerThreadCount.has_value()) {
+        return common::ThreadPool::SizingPolicy::fixed(maxThreadCount);
+    }
+
+    return common::ThreadPool::SizingPolicy{
+        .minThreadCount = config.minWorkerThreadCount.value(),
+        .maxThreadCount = maxThreadCount,
+        .targetQueueWait = config.workerQueueWaitTarget,
+        .idleTimeout = config.workerIdleTimeout};
+}
+}
+
+Server::Impl::Impl(common::Port port, std::size_t maxThreadCount,
+                   const Config& config)
+  : m_config{config},
+    m_running{false},
+    m_counters{},
+    m_threadPool{getSizingPolicy(maxThreadCount, config),
+                 getIdlePolicy(config.idleProfile), config.workerThreadCpus},
+    m_connectionManager{m_threadPool, m_config, m_counters},
+    m_shards{}
+{
+    if(m_config.minReceiveBufferSize < 1) {
+        throw std::invalid_argument{
+            "min receive buffer size must be greater than 0"};
+    }
+
+    if(m_config.minReceiveBufferSize > m_config.maxReceiveBufferSize) {
+        throw std::invalid_argument{
+            "min receive buffer size must not be greater than max receive "
+            "buffer size"};
+    }
+
+    if(m_config.receiveRingCapacity < 1) {
+        throw std::invalid_argument{
+            "receive ring capacity must be greater than 0"};
+    }
+
+    if(m_config.sendHighWaterMark < 1) {
+        throw std::invalid_argument{
+            "send high water mark must be greater than 0"};
+    }
+
+    if(m_config.sendLowWaterMark > m_config.sendHighWaterMark) {
+        throw std::invalid_argument{
+            "send low water mark must not be greater than send high water "
+            "mark"};
+    }
+
+    if(m_config.ioThreadCount < 1) {
+        throw std::invalid_argument{"io thread count must be greater than 0"};
+    }
+
+    // Only share the port when there are multiple shards so that a single
+    // shard fails to bind if another process is already using the port
+    const bool reusePort = m_config.ioThreadCount > 1;
+    const auto endpoint = createListenerEndpoint(port);
+    m_shards.reserve(m_config.ioThreadCount);
+    for(std::size_t i = 0; i < m_config.ioThreadCount; i++) {
+        m_shards.emplace_back(
+            std::make_unique<Shard>(endpoint, m_connectionManager, reusePort));
+    }
 }
 
 void Server::Impl::run()
@@ -38,32 +146,84 @@ void Server::Impl::run()
     if(initialize()) {
         LOG_INFO("Server online");
         m_running = true;
-        m_ioContext.run();
+
+        std::vector<std::thread> threads;
+        threads.reserve(m_shards.size() - 1);
+        for(std::size_t i = 1; i < m_shards.size(); i++) {
+            threads.emplace_back(&Server::Impl::runShard, this, i);
+        }
+
+        runShard(0);
+        for(auto& thread : threads) {
+            thread.join();
+        }
     }
 
     shutdown();
     LOG_INFO("Server offline");
 }
 
+void Server::Impl::runShard(std::size_t index)
+{
+    // Connections are created on their shard's thread, so once the thread is
+    // pinned their memory is placed on the thread's NUMA node
+    const auto& cpus = m_config.ioThreadCpus;
+    if(!cpus.empty() &&
+       !common::affinity::pinCurrentThread({cpus.at(index % cpus.size())})) {
+        LOG_WARN("Failed to pin io thread {} to its CPU", index);
+    }
+
+    m_shards.at(index)->run();
+}
+
 void Server::Impl::stop()
 {
     if(m_running) {
         m_running = false;
-        m_ioContext.stop();
+        for(auto& shard : m_shards) {
+            shard->stop();
+        }
     }
 }
 
+Stats Server::Impl::getStats() const
+{
+    auto stats = m_counters.getStats();
+    stats.queuedHighPriorityJobCount =
+        m_threadPool.getQueuedCount(common::ThreadPool::Priority::High);
+    stats.queuedNormalPriorityJobCount =
+        m_threadPool.getQueuedCount(common::ThreadPool::Priority::Normal);
+    stats.workerThreadCount = m_threadPool.getThreadCount();
+    stats.workerThreadStartCount = m_threadPool.getThreadStartCount();
+    stats.workerThreadRetireCount = m_threadPool.getThreadRetireCount();
+
+    const auto poolStats = m_threadPool.getStats();
+    stats.jobQueueWait = poolStats.queueWait;
+    stats.jobRunTime = poolStats.runTime;
+    stats.maxQueuedJobCount = poolStats.maxQueuedCount;
+    stats.jobStealCount = poolStats.stealCount;
+    stats.workerIdleCount = poolStats.idleCount;
+    stats.jobExceptionCount = poolStats.exceptionCount;
+    return stats;
+}
+
 bool Server::Impl::initialize()
 {
     LOG_INFO("Server initializing");
-    m_listener.start();
+    for(auto& shard : m_shards) {
+        shard->start();
+    }
+
     return true;
 }
 
 void Server::Impl::shutdown()
 {
     LOG_INFO("Server shutting down");
-    m_listener.stop();
+    for(auto& shard : m_shards) {
+        shard->shutdown();
+    }
+
     m_connectionManager.stopAll();
 }
 }
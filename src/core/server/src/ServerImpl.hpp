@@ -1,16 +1,19 @@
 #pragma once
 
 #include "ConnectionManager.hpp"
-#include "Listener.hpp"
+#include "Counters.hpp"
+#include "Shard.hpp"
 
 #include "chat/common/Port.hpp"
 #include "chat/common/ThreadPool.hpp"
+#include "chat/server/Config.hpp"
 #include "chat/server/Server.hpp"
-
-#include <asio/io_context.hpp>
+#include "chat/server/Stats.hpp"
 
 #include <atomic>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 namespace chat::server
 {
@@ -26,8 +29,10 @@ public:
      * @param port The port to listen on.
      *
      * @param maxThreadCount The number of threads for the server to use.
+     *
+     * @param config The tunable settings of the server.
      */
-    Impl(common::Port port, std::size_t maxThreadCount);
+    Impl(common::Port port, std::size_t maxThreadCount, const Config& config);
 
     /**
      * @brief Run the server.
@@ -35,6 +40,9 @@ public:
      * @details This blocks until the server is stopped. Use @c stop() to stop
      * the server. Since this function blocks the current thread, @c stop() must
      * be called on a separate thread.
+     *
+     * The first shard runs on the current thread, and every other shard runs
+     * on a thread of its own.
      */
     void run();
 
@@ -43,6 +51,13 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Get a snapshot of the server's counters.
+     *
+     * @return A snapshot of the server's counters.
+     */
+    [[nodiscard]] Stats getStats() const;
+
 private:
     /**
      * @brief Initialize the server.
@@ -56,10 +71,20 @@ private:
      */
     void shutdown();
 
+    /**
+     * @brief Run a shard on the current thread until it stops.
+     *
+     * @details The thread is first pinned to the shard's CPU, if any.
+     *
+     * @param index The index of the shard.
+     */
+    void runShard(std::size_t index);
+
+    Config m_config;
     std::atomic_bool m_running = false;
+    Counters m_counters;
     common::ThreadPool m_threadPool;
     ConnectionManager m_connectionManager;
-    asio::io_context m_ioContext;
-    Listener m_listener;
+    std::vector<std::unique_ptr<Shard>> m_shards;
 };
 }
@@ -0,0 +1,36 @@
+#include "Shard.hpp"
+
+#include "ConnectionManager.hpp"
+
+#include <asio/ip/tcp.hpp>
+
+namespace chat::server
+{
+Shard::Shard(const asio::ip::tcp::endpoint& endpoint,
+             ConnectionManager& connectionManager, bool reusePort)
+  // The execution context is only ever run by the shard's thread, which lets
+  // Asio skip waking other threads when work is posted
+  : m_ioContext{1},
+    m_listener{m_ioContext, endpoint, connectionManager, reusePort}
+{}
+
+void Shard::start()
+{
+    m_listener.start();
+}
+
+void Shard::run()
+{
+    m_ioContext.run();
+}
+
+void Shard::stop()
+{
+    m_ioContext.stop();
+}
+
+void Shard::shutdown()
+{
+    m_listener.stop();
+}
+}
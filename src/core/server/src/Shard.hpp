@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ConnectionManager.hpp"
+#include "Listener.hpp"
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+
+namespace chat::server
+{
+/**
+ * @brief An independent slice of the server's I/O.
+ *
+ * @details A shard owns an I/O execution context and a listener. The
+ * connections accepted by the shard's listener perform all their I/O on the
+ * shard's execution context, so a connection never leaves the shard it was
+ * accepted on. The shards share the server's connection manager, which only
+ * takes a lock when a connection is created or destroyed, so each shard can
+ * run on its own thread without contention.
+ *
+ * When the server has multiple shards, their listeners bind to the same
+ * endpoint with @c SO_REUSEPORT, and the operating system distributes incoming
+ * connections between them.
+ */
+class Shard
+{
+public:
+    /**
+     * @brief Construct a shard.
+     *
+     * @param endpoint The endpoint to listen for connections on.
+     * @param connectionManager The manager for the accepted connections.
+     * @param reusePort Whether the listener allows other listeners to bind to
+     * the same endpoint.
+     */
+    Shard(const asio::ip::tcp::endpoint& endpoint,
+          ConnectionManager& connectionManager, bool reusePort);
+
+    /**
+     * @brief Copy operations are disabled.
+     * @{
+     */
+    Shard(const Shard& other) = delete;
+    Shard& operator=(const Shard& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Move operations are disabled.
+     * @{
+     */
+    Shard(Shard&& other) = delete;
+    Shard& operator=(Shard&& other) = delete;
+    /** @} */
+
+    /**
+     * @brief Destroy the shard.
+     */
+    ~Shard() = default;
+
+    /**
+     * @brief Start listening for connections.
+     */
+    void start();
+
+    /**
+     * @brief Run the shard's I/O.
+     *
+     * @details This blocks until @c stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Notify the shard's I/O to stop.
+     *
+     * @details This can be called from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Stop listening for connections.
+     *
+     * @details This must only be called once @c run() has returned.
+     */
+    void shutdown();
+
+private:
+    asio::io_context m_ioContext;
+    Listener m_listener;
+};
+}
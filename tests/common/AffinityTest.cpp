@@ -0,0 +1,102 @@
+#include "chat/common/affinity.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+TEST_CASE("Parsing CPU lists", "[affinity]")
+{
+    using chat::common::affinity::CpuSet;
+    using chat::common::affinity::parseCpuList;
+
+    SECTION("Single CPUs")
+    {
+        REQUIRE(parseCpuList("3") == CpuSet{3});
+        REQUIRE(parseCpuList("0,2,5") == CpuSet{0, 2, 5});
+    }
+
+    SECTION("Ranges of CPUs")
+    {
+        REQUIRE(parseCpuList("0-3") == CpuSet{0, 1, 2, 3});
+        REQUIRE(parseCpuList("4-4") == CpuSet{4});
+        REQUIRE(parseCpuList("0-1,8,10-11") == CpuSet{0, 1, 8, 10, 11});
+    }
+
+    SECTION("Lists with too many CPUs")
+    {
+        REQUIRE(parseCpuList("0-4095")->size() == 4096);
+        REQUIRE_FALSE(parseCpuList("0-4095,0").has_value());
+        REQUIRE_FALSE(parseCpuList("0-2047,0-2047,0-2047").has_value());
+    }
+
+    SECTION("Malformed lists")
+    {
+        REQUIRE_FALSE(parseCpuList("").has_value());
+        REQUIRE_FALSE(parseCpuList(",").has_value());
+        REQUIRE_FALSE(parseCpuList("1,").has_value());
+        REQUIRE_FALSE(parseCpuList("a").has_value());
+        REQUIRE_FALSE(parseCpuList("1-").has_value());
+        REQUIRE_FALSE(parseCpuList("-1").has_value());
+        REQUIRE_FALSE(parseCpuList("3-1").has_value());
+        REQUIRE_FALSE(parseCpuList("1 ,2").has_value());
+        REQUIRE_FALSE(parseCpuList("0-99999999999").has_value());
+    }
+}
+
+#if defined(__linux__)
+namespace
+{
+std::optional<chat::common::affinity::CpuSet> getCurrentCpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return std::nullopt;
+    }
+
+    chat::common::affinity::CpuSet cpus;
+    for(std::size_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+}
+#endif
+
+TEST_CASE("Pinning the current thread", "[affinity]")
+{
+    using chat::common::affinity::pinCurrentThread;
+
+    REQUIRE(pinCurrentThread({}));
+
+#if defined(__linux__)
+    // The thread is pinned to a CPU it's already allowed to run on, which might
+    // not be CPU 0 in a container. The pinned thread is a separate one so that
+    // the other tests still run on every CPU.
+    std::optional<chat::common::affinity::CpuSet> allowed;
+    bool pinned = false;
+    std::optional<chat::common::affinity::CpuSet> current;
+    std::thread thread{[&] {
+        allowed = getCurrentCpus();
+        if(allowed.has_value() && !allowed->empty()) {
+            pinned = pinCurrentThread({allowed->back()});
+            current = getCurrentCpus();
+        }
+    }};
+    thread.join();
+
+    REQUIRE(allowed.has_value());
+    REQUIRE(!allowed->empty());
+    REQUIRE(pinned);
+    REQUIRE(current == chat::common::affinity::CpuSet{allowed->back()});
+#endif
+}
@@ -0,0 +1,138 @@
+#include "chat/common/Buffer.hpp"
+#include "chat/common/BufferView.hpp"
+#include "chat/common/ByteRing.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+namespace
+{
+chat::common::Buffer createData(std::size_t size)
+{
+    chat::common::Buffer data(size);
+    for(std::size_t i = 0; i < size; i++) {
+        data.at(i) = static_cast<std::byte>(i);
+    }
+
+    return data;
+}
+}
+
+TEST_CASE("Constructing a byte ring", "[ByteRing]")
+{
+    SECTION("Capacity is a power of 2")
+    {
+        const chat::common::ByteRing ring{16};
+        REQUIRE(ring.getCapacity() == 16);
+    }
+
+    SECTION("Capacity is not a power of 2")
+    {
+        const chat::common::ByteRing ring{10};
+        REQUIRE(ring.getCapacity() == 16);
+    }
+
+    SECTION("Capacity is 0")
+    {
+        const chat::common::ByteRing ring{0};
+        REQUIRE(ring.getCapacity() == 1);
+    }
+}
+
+TEST_CASE("Writing to and reading from a byte ring", "[ByteRing]")
+{
+    chat::common::ByteRing ring{16};
+    REQUIRE(ring.getReadable().empty());
+    REQUIRE(ring.getWritable().size() == 16);
+
+    const auto data = createData(10);
+    REQUIRE(ring.write(chat::common::BufferView{data}) == data.size());
+    REQUIRE(ring.getWritable().size() == 6);
+
+    const auto readable = ring.getReadable();
+    REQUIRE(std::ranges::equal(readable, data));
+
+    ring.commitRead(readable.size());
+    REQUIRE(ring.getReadable().empty());
+}
+
+TEST_CASE("Writing to a full byte ring", "[ByteRing]")
+{
+    chat::common::ByteRing ring{16};
+    const auto data = createData(20);
+    REQUIRE(ring.write(chat::common::BufferView{data}) == 16);
+    REQUIRE(ring.getWritable().empty());
+    REQUIRE(ring.write(chat::common::BufferView{data}) == 0);
+
+    REQUIRE(ring.getReadable().size() == 16);
+    ring.commitRead(4);
+    REQUIRE(ring.getWritable().size() == 4);
+}
+
+TEST_CASE("Writing around the end of a byte ring", "[ByteRing]")
+{
+    chat::common::ByteRing ring{16};
+    const auto padding = createData(12);
+    REQUIRE(ring.write(chat::common::BufferView{padding}) == padding.size());
+    REQUIRE(ring.getReadable().size() == padding.size());
+    ring.commitRead(padding.size());
+
+    const auto data = createData(10);
+    REQUIRE(ring.write(chat::common::BufferView{data}) == data.size());
+
+    // The used space is split in two at the end of the ring
+    auto readable = ring.getReadable();
+    REQUIRE(readable.size() == 4);
+    REQUIRE(std::ranges::equal(readable,
+                               chat::common::BufferView{data}.first(4)));
+    ring.commitRead(readable.size());
+
+    readable = ring.getReadable();
+    REQUIRE(readable.size() == 6);
+    REQUIRE(std::ranges::equal(readable,
+                               chat::common::BufferView{data}.subspan(4)));
+    ring.commitRead(readable.size());
+    REQUIRE(ring.getReadable().empty());
+}
+
+TEST_CASE("Writing to and reading from a byte ring on different threads",
+          "[ByteRing]")
+{
+    constexpr std::size_t size = 1024 * 1024;
+    constexpr std::size_t chunkSize = 100;
+    const auto data = createData(size);
+    chat::common::ByteRing ring{64};
+
+    std::thread producer{[&] {
+        const chat::common::BufferView view{data};
+        std::size_t written = 0;
+        while(written < size) {
+            const auto chunk =
+                view.subspan(written, std::min(chunkSize, size - written));
+            const std::size_t count = ring.write(chunk);
+            if(count == 0) {
+                std::this_thread::yield();
+            }
+
+            written += count;
+        }
+    }};
+
+    chat::common::Buffer received;
+    received.reserve(size);
+    while(received.size() < size) {
+        const auto readable = ring.getReadable();
+        if(readable.empty()) {
+            std::this_thread::yield();
+        }
+
+        received.insert(received.end(), readable.begin(), readable.end());
+        ring.commitRead(readable.size());
+    }
+
+    producer.join();
+    REQUIRE(received == data);
+}
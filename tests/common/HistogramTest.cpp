@@ -0,0 +1,77 @@
+#include "chat/common/Histogram.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <limits>
+
+TEST_CASE("Taking a snapshot of an empty histogram", "[Histogram]")
+{
+    const chat::common::Histogram histogram;
+    const auto snapshot = histogram.getSnapshot();
+    REQUIRE(snapshot.getCount() == 0);
+    REQUIRE(snapshot.getSum() == 0);
+    REQUIRE(snapshot.getPercentile(50) == 0);
+}
+
+TEST_CASE("Recording small values into a histogram", "[Histogram]")
+{
+    // Values below 8 have a bucket each, so their percentiles are exact
+    chat::common::Histogram histogram;
+    for(std::uint64_t value = 0; value < 8; value++) {
+        histogram.record(value);
+    }
+
+    const auto snapshot = histogram.getSnapshot();
+    REQUIRE(snapshot.getCount() == 8);
+    REQUIRE(snapshot.getSum() == 28);
+    REQUIRE(snapshot.getPercentile(0) == 0);
+    REQUIRE(snapshot.getPercentile(50) == 3);
+    REQUIRE(snapshot.getPercentile(100) == 7);
+}
+
+TEST_CASE("Recording large values into a histogram", "[Histogram]")
+{
+    chat::common::Histogram histogram;
+    constexpr std::uint64_t value = 1'000'000;
+    histogram.record(value);
+
+    // The percentile is the upper bound of the bucket, which is at most 12.5%
+    // above the value
+    const auto percentile = histogram.getSnapshot().getPercentile(50);
+    REQUIRE(percentile >= value);
+    REQUIRE(percentile <= value + (value / 8));
+
+    histogram.record(std::numeric_limits<std::uint64_t>::max());
+    REQUIRE(histogram.getSnapshot().getPercentile(100) ==
+            std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST_CASE("Finding percentiles of a histogram", "[Histogram]")
+{
+    chat::common::Histogram histogram;
+    for(int i = 0; i < 99; i++) {
+        histogram.record(1);
+    }
+    histogram.record(1000);
+
+    const auto snapshot = histogram.getSnapshot();
+    REQUIRE(snapshot.getPercentile(50) == 1);
+    REQUIRE(snapshot.getPercentile(99) == 1);
+    REQUIRE(snapshot.getPercentile(100) >= 1000);
+}
+
+TEST_CASE("Merging snapshots of histograms", "[Histogram]")
+{
+    chat::common::Histogram first;
+    chat::common::Histogram second;
+    first.record(1);
+    second.record(2);
+    second.record(3);
+
+    auto snapshot = first.getSnapshot();
+    snapshot.merge(second.getSnapshot());
+    REQUIRE(snapshot.getCount() == 3);
+    REQUIRE(snapshot.getSum() == 6);
+    REQUIRE(snapshot.getPercentile(100) == 3);
+}
@@ -0,0 +1,89 @@
+#include "chat/common/Job.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <utility>
+
+TEST_CASE("Constructing an empty job", "[Job]")
+{
+    const chat::common::Job job;
+    REQUIRE(!job);
+}
+
+TEST_CASE("Running a job", "[Job]")
+{
+    int count = 0;
+    chat::common::Job job{[&count] { count++; }};
+    REQUIRE(job);
+
+    job();
+    job();
+    REQUIRE(count == 2);
+}
+
+TEST_CASE("Running a job with move-only captures", "[Job]")
+{
+    int value = 0;
+    auto pointer = std::make_unique<int>(1);
+    chat::common::Job job{
+        [&value, pointer = std::move(pointer)] { value = *pointer; }};
+
+    job();
+    REQUIRE(value == 1);
+}
+
+TEST_CASE("Moving a job", "[Job]")
+{
+    auto counter = std::make_shared<int>(0);
+    chat::common::Job job{[counter] { (*counter)++; }};
+    REQUIRE(counter.use_count() == 2);
+
+    SECTION("Move constructing")
+    {
+        chat::common::Job other{std::move(job)};
+        // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+        REQUIRE(!job);
+        REQUIRE(other);
+        REQUIRE(counter.use_count() == 2);
+
+        other();
+        REQUIRE(*counter == 1);
+    }
+
+    SECTION("Move assigning")
+    {
+        auto otherCounter = std::make_shared<int>(0);
+        chat::common::Job other{[otherCounter] { (*otherCounter)++; }};
+        other = std::move(job);
+        // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+        REQUIRE(!job);
+        REQUIRE(otherCounter.use_count() == 1);
+        REQUIRE(counter.use_count() == 2);
+
+        other();
+        REQUIRE(*counter == 1);
+        REQUIRE(*otherCounter == 0);
+    }
+}
+
+TEST_CASE("Destroying the function of a job", "[Job]")
+{
+    auto counter = std::make_shared<int>(0);
+
+    SECTION("Resetting")
+    {
+        chat::common::Job job{[counter] { (*counter)++; }};
+        job.reset();
+        REQUIRE(!job);
+        REQUIRE(counter.use_count() == 1);
+    }
+
+    SECTION("Destroying")
+    {
+        {
+            const chat::common::Job job{[counter] { (*counter)++; }};
+        }
+        REQUIRE(counter.use_count() == 1);
+    }
+}
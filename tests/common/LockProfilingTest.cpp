@@ -0,0 +1,90 @@
+#include "chat/common/LockProfiling.hpp"
+#include "chat/common/Synced.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace
+{
+std::optional<chat::common::LockStats> findLockStats(std::string_view name)
+{
+    for(auto& stats : chat::common::getLockStats()) {
+        if(stats.name == name) {
+            return std::move(stats);
+        }
+    }
+    return std::nullopt;
+}
+}
+
+TEST_CASE("Recording how a lock is used", "[LockProfiling]")
+{
+    std::mutex mutex;
+    {
+        chat::common::detail::LockProfile profile{
+            chat::common::LockName{"LockProfilingTest::profile"}};
+        std::unique_lock lock{mutex, std::defer_lock};
+        const auto acquiredAt = profile.acquire(lock);
+        REQUIRE(lock.owns_lock());
+        profile.release(acquiredAt);
+
+        const auto stats = findLockStats("LockProfilingTest::profile");
+        REQUIRE(stats.has_value());
+        REQUIRE(stats->acquireCount == 1);
+        REQUIRE(stats->contendedCount == 0);
+        REQUIRE(stats->wait.getPercentile(100) == 0);
+        REQUIRE(stats->hold.getCount() == 1);
+    }
+
+    // What a destroyed profile recorded is kept
+    const auto stats = findLockStats("LockProfilingTest::profile");
+    REQUIRE(stats.has_value());
+    REQUIRE(stats->acquireCount == 1);
+}
+
+TEST_CASE("Profiling a contended synchronized object", "[LockProfiling]")
+{
+    chat::common::Synced<int> value{
+        chat::common::LockName{"LockProfilingTest::synced"}, 0};
+
+    // The main thread holds the lock until the other thread has had time to
+    // start waiting for it
+    std::atomic_bool locking = false;
+    std::thread waiter;
+    {
+        auto proxy = value.lock();
+        waiter = std::thread{[&] {
+            locking = true;
+            auto waiting = value.lock();
+            waiting.get()++;
+        }};
+        while(!locking) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        proxy.get()++;
+    }
+    waiter.join();
+    {
+        auto proxy = value.lock();
+        REQUIRE(proxy.get() == 2);
+    }
+
+    const auto stats = findLockStats("LockProfilingTest::synced");
+    if constexpr(chat::common::isLockProfilingEnabled) {
+        REQUIRE(stats.has_value());
+        REQUIRE(stats->acquireCount == 3);
+        REQUIRE(stats->contendedCount == 1);
+        REQUIRE(stats->wait.getPercentile(100) > 0);
+        REQUIRE(stats->hold.getCount() == 3);
+    } else {
+        REQUIRE(!stats.has_value());
+    }
+}
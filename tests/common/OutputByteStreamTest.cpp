@@ -9,6 +9,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <stdexcept>
 
 namespace
 {
@@ -115,3 +116,44 @@ TEST_CASE("Writing a buffer into a stream", "[OutputByteStream]")
     REQUIRE(std::equal(stream.getData().begin(), stream.getData().end(),
                        expected.begin()));
 }
+
+TEST_CASE("Back-patching a length in a stream", "[OutputByteStream]")
+{
+    constexpr auto bytes = createBytes();
+    const chat::common::BufferView view{bytes.data(), bytes.size()};
+
+    // Reserving and patching a length gives the same bytes as writing a
+    // buffer view
+    chat::common::OutputByteStream stream;
+    const auto position = stream.reserveLength();
+    REQUIRE(position == 0);
+    stream.write(view);
+    stream.patchLength(position);
+
+    constexpr auto expected = createSizedBytes(bytes);
+    REQUIRE(stream.getData().size() == expected.size());
+    REQUIRE(std::equal(stream.getData().begin(), stream.getData().end(),
+                       expected.begin()));
+
+    SECTION("The position isn't followed by room for a length")
+    {
+        const auto end = stream.getData().size();
+        REQUIRE_THROWS_AS(stream.patchLength(end), std::invalid_argument);
+        REQUIRE_THROWS_AS(stream.patchLength(end - 1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Taking the data out of a stream", "[OutputByteStream]")
+{
+    constexpr auto bytes = createBytes();
+    const chat::common::BufferView view{bytes.data(), bytes.size()};
+
+    chat::common::OutputByteStream stream{bytes.size()};
+    stream.write(view);
+    const auto* data = stream.getData().data();
+
+    const auto taken = stream.takeData();
+    REQUIRE(taken.data() == data);
+    REQUIRE(std::equal(taken.begin(), taken.end(), bytes.begin(), bytes.end()));
+    REQUIRE(stream.getData().empty());
+}
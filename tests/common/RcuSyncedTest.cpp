@@ -0,0 +1,162 @@
+#include "chat/common/RcuSynced.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct Counted
+{
+    explicit Counted(std::uint64_t value, std::atomic_int& liveCount)
+      : value{value},
+        liveCount{&liveCount}
+    {
+        liveCount++;
+    }
+
+    Counted(const Counted& other)
+      : value{other.value},
+        liveCount{other.liveCount}
+    {
+        (*liveCount)++;
+    }
+
+    Counted& operator=(const Counted& other) = delete;
+    Counted(Counted&& other) = delete;
+    Counted& operator=(Counted&& other) = delete;
+
+    ~Counted()
+    {
+        (*liveCount)--;
+    }
+
+    std::uint64_t value;
+    std::atomic_int* liveCount;
+};
+
+struct Pair
+{
+    std::uint64_t first = 0;
+    std::uint64_t second = 0;
+};
+}
+
+TEST_CASE("Publishing a new version of an RCU object", "[RcuSynced]")
+{
+    chat::common::RcuSynced<std::vector<int>> value{std::vector<int>{1, 2}};
+    {
+        auto snapshot = value.read();
+        REQUIRE(snapshot->size() == 2);
+    }
+
+    value.publish(std::vector<int>{3});
+    {
+        auto snapshot = value.read();
+        REQUIRE(snapshot.get() == std::vector<int>{3});
+    }
+
+    value.update([](std::vector<int>& current) { current.push_back(4); });
+    auto snapshot = value.read();
+    REQUIRE(*snapshot == std::vector<int>{3, 4});
+}
+
+TEST_CASE("Reading a pinned version of an RCU object", "[RcuSynced]")
+{
+    std::atomic_int liveCount = 0;
+    chat::common::RcuSynced<Counted> value{1, liveCount};
+
+    SECTION("The pinned version outlives being replaced")
+    {
+        {
+            auto snapshot = value.read();
+            value.update([](Counted& current) { current.value = 2; });
+            REQUIRE(snapshot->value == 1);
+            REQUIRE(liveCount == 2);
+            REQUIRE(value.getRetiredCount() == 1);
+
+            auto newer = value.read();
+            REQUIRE(newer->value == 2);
+        }
+
+        value.reclaim();
+        REQUIRE(liveCount == 1);
+        REQUIRE(value.getRetiredCount() == 0);
+    }
+
+    SECTION("The next writer reclaims unpinned versions")
+    {
+        {
+            auto snapshot = value.read();
+            value.update([](Counted& current) { current.value = 2; });
+        }
+
+        value.update([](Counted& current) { current.value = 3; });
+        REQUIRE(liveCount == 1);
+        auto snapshot = value.read();
+        REQUIRE(snapshot->value == 3);
+    }
+
+    SECTION("Every reader slot is in use")
+    {
+        // Snapshots can't be moved, so they're held on the stack of recursive
+        // calls
+        constexpr int snapshotCount = 200;
+        const auto pin = [&](const auto& self, int remaining) -> void {
+            auto snapshot = value.read();
+            if(remaining > 1) {
+                self(self, remaining - 1);
+                return;
+            }
+
+            value.update([](Counted& current) { current.value = 2; });
+            REQUIRE(snapshot->value == 1);
+            REQUIRE(value.getRetiredCount() == 1);
+        };
+        pin(pin, snapshotCount);
+
+        value.reclaim();
+        REQUIRE(liveCount == 1);
+    }
+}
+
+TEST_CASE("Reading an RCU object while it's published", "[RcuSynced]")
+{
+    chat::common::RcuSynced<Pair> value;
+
+    // The writer keeps both halves equal, so a reader seeing them differ has
+    // seen a version that was modified or destroyed while pinned
+    std::atomic_bool stop = false;
+    std::thread writer{[&] {
+        for(std::uint64_t i = 1; !stop; i++) {
+            value.publish(Pair{.first = i, .second = i});
+        }
+    }};
+
+    constexpr int readerCount = 4;
+    constexpr int readCount = 20000;
+    std::atomic_bool torn = false;
+    std::vector<std::thread> readers;
+    for(int i = 0; i < readerCount; i++) {
+        readers.emplace_back([&] {
+            for(int j = 0; j < readCount; j++) {
+                auto snapshot = value.read();
+                const auto first = snapshot->first;
+                std::this_thread::yield();
+                if(snapshot->second != first) {
+                    torn = true;
+                }
+            }
+        });
+    }
+
+    for(auto& reader : readers) {
+        reader.join();
+    }
+    stop = true;
+    writer.join();
+    REQUIRE(!torn);
+}
@@ -0,0 +1,77 @@
+#include "chat/common/SeqSynced.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct Pair
+{
+    std::uint64_t first = 0;
+    std::uint64_t second = 0;
+    std::uint8_t tail = 0;
+};
+}
+
+TEST_CASE("Storing into a sequence-locked value", "[SeqSynced]")
+{
+    chat::common::SeqSynced<Pair> value{Pair{.first = 1, .second = 2}};
+    REQUIRE(value.load().first == 1);
+    REQUIRE(value.load().second == 2);
+
+    value.store(Pair{.first = 3, .second = 4, .tail = 5});
+    const auto loaded = value.load();
+    REQUIRE(loaded.first == 3);
+    REQUIRE(loaded.second == 4);
+    REQUIRE(loaded.tail == 5);
+}
+
+TEST_CASE("Updating a sequence-locked value", "[SeqSynced]")
+{
+    chat::common::SeqSynced<std::uint64_t> value;
+
+    constexpr int threadCount = 4;
+    constexpr int updateCount = 1000;
+    std::vector<std::thread> threads;
+    for(int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&] {
+            for(int j = 0; j < updateCount; j++) {
+                value.update([](std::uint64_t& current) { current++; });
+            }
+        });
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(value.load() == threadCount * updateCount);
+}
+
+TEST_CASE("Reading a sequence-locked value while it's written",
+          "[SeqSynced]")
+{
+    chat::common::SeqSynced<Pair> value;
+
+    // The writer keeps both halves equal, so a reader seeing them differ has
+    // seen a torn write
+    std::atomic_bool stop = false;
+    std::thread writer{[&] {
+        for(std::uint64_t i = 1; !stop; i++) {
+            value.store(Pair{.first = i, .second = i});
+        }
+    }};
+
+    bool torn = false;
+    constexpr int readCount = 100000;
+    for(int i = 0; i < readCount; i++) {
+        const auto loaded = value.load();
+        torn = torn || loaded.first != loaded.second;
+    }
+    stop = true;
+    writer.join();
+    REQUIRE(!torn);
+}
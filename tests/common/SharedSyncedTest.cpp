@@ -0,0 +1,62 @@
+#include "chat/common/SharedSynced.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <string>
+#include <thread>
+
+TEST_CASE("Modifying a shared synchronized object", "[SharedSynced]")
+{
+    chat::common::SharedSynced<std::string> object{"initial"};
+    {
+        auto locked = object.lock();
+        locked.get() = "new";
+    }
+
+    auto locked = object.lockShared();
+    REQUIRE(locked.get() == "new");
+}
+
+TEST_CASE("Shared synchronized object lets readers share access",
+          "[SharedSynced]")
+{
+    const chat::common::SharedSynced<std::string> object{"initial"};
+
+    // Both readers only get past the latch if they hold the object at the same
+    // time
+    std::latch latch{2};
+    std::thread thread{[&] {
+        auto locked = object.lock();
+        latch.arrive_and_wait();
+    }};
+
+    auto locked = object.lock();
+    latch.arrive_and_wait();
+    REQUIRE(locked.get() == "initial");
+    thread.join();
+}
+
+TEST_CASE("Shared synchronized object gives writers exclusive access",
+          "[SharedSynced]")
+{
+    chat::common::SharedSynced<std::string> object;
+
+    constexpr std::chrono::milliseconds minLockTime{100};
+    std::latch latch{1};
+    std::thread thread{[&] {
+        auto locked = object.lock();
+        latch.count_down();
+        std::this_thread::sleep_for(minLockTime);
+    }};
+
+    latch.wait();
+    auto start = std::chrono::system_clock::now();
+    auto locked = object.lockShared();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now() - start);
+    REQUIRE(elapsed >= minLockTime);
+    thread.join();
+}
@@ -0,0 +1,89 @@
+#include "chat/common/SlotMap.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set>
+#include <string>
+
+TEST_CASE("Inserting into a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<std::string> map;
+    REQUIRE(map.empty());
+
+    const auto key1 = map.insert("first");
+    const auto key2 = map.insert("second");
+    REQUIRE(key1 != key2);
+    REQUIRE(key1 != chat::common::SlotMap<std::string>::nullKey);
+    REQUIRE(key2 != chat::common::SlotMap<std::string>::nullKey);
+    REQUIRE(map.size() == 2);
+
+    REQUIRE(map.find(key1) != nullptr);
+    REQUIRE(*map.find(key1) == "first");
+    REQUIRE(map.find(key2) != nullptr);
+    REQUIRE(*map.find(key2) == "second");
+}
+
+TEST_CASE("Erasing from a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<std::string> map;
+    const auto key = map.insert("value");
+
+    REQUIRE(map.erase(key));
+    REQUIRE(map.empty());
+    REQUIRE(map.find(key) == nullptr);
+    REQUIRE(!map.erase(key));
+}
+
+TEST_CASE("Reusing a slot of a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<std::string> map;
+    const auto oldKey = map.insert("old");
+    REQUIRE(map.erase(oldKey));
+
+    // The new object reuses the slot, but the old key must not find it
+    const auto newKey = map.insert("new");
+    REQUIRE(newKey != oldKey);
+    REQUIRE(map.find(oldKey) == nullptr);
+    REQUIRE(!map.erase(oldKey));
+    REQUIRE(map.find(newKey) != nullptr);
+    REQUIRE(*map.find(newKey) == "new");
+}
+
+TEST_CASE("Finding with the null key in a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<std::string> map;
+    static_cast<void>(map.insert("value"));
+    REQUIRE(map.find(chat::common::SlotMap<std::string>::nullKey) == nullptr);
+}
+
+TEST_CASE("Visiting every object of a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<int> map;
+    constexpr int count = 10;
+    std::set<chat::common::SlotMap<int>::Key> keys;
+    for(int i = 0; i < count; i++) {
+        keys.insert(map.insert(i));
+    }
+
+    std::set<chat::common::SlotMap<int>::Key> visited;
+    int sum = 0;
+    map.forEach([&](chat::common::SlotMap<int>::Key key, int value) {
+        visited.insert(key);
+        sum += value;
+    });
+
+    REQUIRE(visited == keys);
+    REQUIRE(sum == 45);
+}
+
+TEST_CASE("Clearing a slot map", "[SlotMap]")
+{
+    chat::common::SlotMap<int> map;
+    const auto key1 = map.insert(1);
+    const auto key2 = map.insert(2);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.find(key1) == nullptr);
+    REQUIRE(map.find(key2) == nullptr);
+}
@@ -0,0 +1,132 @@
+#include "chat/common/Strand.hpp"
+#include "chat/common/ThreadPool.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Queueing jobs into a strand runs them in order", "[Strand]")
+{
+    constexpr int threadCount = 4;
+    chat::common::ThreadPool pool{threadCount};
+    chat::common::Strand strand{pool};
+
+    // More jobs than a runner runs at once so that it's queued back into the
+    // thread pool
+    constexpr int jobCount = 1000;
+    std::vector<int> order;
+    pool.pause();
+    for(int i = 0; i < jobCount; i++) {
+        strand.queue([&order, i] { order.push_back(i); });
+    }
+    pool.resume();
+    pool.waitForCompletion();
+
+    std::vector<int> expected(jobCount);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(order == expected);
+}
+
+TEST_CASE("Queueing jobs into a strand never runs them at the same time",
+          "[Strand]")
+{
+    constexpr int threadCount = 4;
+    chat::common::ThreadPool pool{threadCount};
+    chat::common::Strand strand{pool};
+
+    constexpr int jobCount = 1000;
+    std::atomic_int runningCount = 0;
+    std::atomic_bool overlapped = false;
+    for(int i = 0; i < jobCount; i++) {
+        strand.queue([&] {
+            if(runningCount.fetch_add(1) != 0) {
+                overlapped = true;
+            }
+            runningCount.fetch_sub(1);
+        });
+    }
+    pool.waitForCompletion();
+
+    REQUIRE(!overlapped);
+}
+
+TEST_CASE("Queueing jobs into multiple strands", "[Strand]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{threadCount};
+    chat::common::Strand strand1{pool};
+    chat::common::Strand strand2{pool};
+
+    constexpr int jobCount = 100;
+    std::atomic_int count1 = 0;
+    std::atomic_int count2 = 0;
+    for(int i = 0; i < jobCount; i++) {
+        strand1.queue([&] { count1++; });
+        strand2.queue([&] { count2++; });
+    }
+    pool.waitForCompletion();
+
+    REQUIRE(count1 == jobCount);
+    REQUIRE(count2 == jobCount);
+}
+
+TEST_CASE("Queueing a job that throws into a strand", "[Strand]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+    chat::common::Strand strand{pool};
+
+    std::atomic_int count = 0;
+    pool.pause();
+    strand.queue([] { throw std::runtime_error{"error"}; });
+    strand.queue([&] { count++; });
+    pool.resume();
+    pool.waitForCompletion();
+
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Destroying a strand with queued jobs", "[Strand]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+
+    std::atomic_int count = 0;
+    pool.pause();
+    {
+        std::optional<chat::common::Strand> strand;
+        strand.emplace(pool);
+        strand->queue([&] { count++; });
+    }
+    pool.resume();
+    pool.waitForCompletion();
+
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Queueing many jobs into a strand gives its thread back",
+          "[Strand]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+    chat::common::Strand strand{pool};
+
+    // A runner runs at most 64 jobs before queueing itself back into the pool,
+    // even when more were queued at once
+    constexpr int jobCount = 200;
+    constexpr int runnerCount = 4;
+    std::atomic_int count = 0;
+    pool.pause();
+    for(int i = 0; i < jobCount; i++) {
+        strand.queue([&] { count++; });
+    }
+    pool.resume();
+    pool.waitForCompletion();
+
+    REQUIRE(count == jobCount);
+    REQUIRE(pool.getStats().queueWait.getCount() == runnerCount);
+}
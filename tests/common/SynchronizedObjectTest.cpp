@@ -8,6 +8,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <tuple>
 
 namespace
 {
@@ -77,3 +78,99 @@ TEST_CASE("Synchronized object provides mutual exclusive access", "[Synced]")
         thread.join();
     }
 }
+
+TEST_CASE("Locking several synchronized objects at once", "[Synced]")
+{
+    chat::common::Synced<std::string> first{getInitialValue()};
+    const chat::common::Synced<std::string> second{getNewValue()};
+
+    auto [lockedFirst, lockedSecond] = chat::common::lockAll(first, second);
+    lockedFirst.get() = lockedSecond.get();
+    REQUIRE(lockedFirst.get() == getNewValue());
+}
+
+TEST_CASE("Locking synchronized objects in different orders", "[Synced]")
+{
+    chat::common::Synced<int> first{0};
+    chat::common::Synced<int> second{0};
+
+    // Locking the objects one at a time in opposite orders would eventually
+    // deadlock
+    constexpr int iterationCount = 10000;
+    std::thread thread{[&] {
+        for(int i = 0; i < iterationCount; i++) {
+            auto [lockedFirst, lockedSecond] =
+                chat::common::lockAll(first, second);
+            lockedFirst.get()++;
+            lockedSecond.get()--;
+        }
+    }};
+
+    for(int i = 0; i < iterationCount; i++) {
+        auto [lockedSecond, lockedFirst] = chat::common::lockAll(second, first);
+        lockedFirst.get()++;
+        lockedSecond.get()--;
+    }
+    thread.join();
+
+    auto [lockedFirst, lockedSecond] = chat::common::lockAll(first, second);
+    REQUIRE(lockedFirst.get() == 2 * iterationCount);
+    REQUIRE(lockedSecond.get() == -2 * iterationCount);
+}
+
+TEST_CASE("Trying to lock several synchronized objects", "[Synced]")
+{
+    chat::common::Synced<std::string> first{getInitialValue()};
+    chat::common::Synced<std::string> second{getInitialValue()};
+
+    SECTION("None of the objects are locked")
+    {
+        auto locked = chat::common::tryLock(first, second);
+        REQUIRE(locked.has_value());
+        std::get<0>(*locked).get() = getNewValue();
+        REQUIRE(std::get<0>(*locked).get() == getNewValue());
+    }
+
+    SECTION("One of the objects is locked")
+    {
+        // The object is locked by another thread, since a thread can't try to
+        // lock a mutex it already holds
+        std::mutex mutex;
+        bool locked = false;
+        bool release = false;
+        std::condition_variable condvar;
+        std::thread thread{[&] {
+            auto lockedSecond = second.lock();
+            std::unique_lock lock{mutex};
+            locked = true;
+            condvar.notify_one();
+            condvar.wait(lock, [&] { return release; });
+        }};
+
+        {
+            std::unique_lock lock{mutex};
+            condvar.wait(lock, [&] { return locked; });
+        }
+
+        REQUIRE(!chat::common::tryLock(first, second).has_value());
+
+        constexpr std::chrono::milliseconds timeout{20};
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(!chat::common::tryLockFor(timeout, first, second).has_value());
+        REQUIRE(std::chrono::steady_clock::now() - start >= timeout);
+
+        // The object that wasn't locked is left unlocked
+        REQUIRE(chat::common::tryLock(first).has_value());
+
+        {
+            const std::lock_guard lock{mutex};
+            release = true;
+        }
+        condvar.notify_one();
+        thread.join();
+
+        constexpr std::chrono::seconds longTimeout{10};
+        REQUIRE(
+            chat::common::tryLockFor(longTimeout, first, second).has_value());
+    }
+}
@@ -1,10 +1,18 @@
+#include "chat/common/Job.hpp"
 #include "chat/common/ThreadPool.hpp"
 
 #include <catch2/catch_test_macros.hpp>
 
 #include <atomic>
 #include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <latch>
+#include <memory>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -19,6 +27,83 @@ auto getElapsedTime(std::chrono::system_clock::time_point start)
 {
     return std::chrono::duration_cast<std::chrono::milliseconds>(now() - start);
 }
+
+/**
+ * @brief A coroutine that starts immediately and that nothing waits for.
+ */
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+DetachedCoroutine hopOntoPool(chat::common::ThreadPool& pool,
+                              std::thread::id& threadId, std::latch& latch)
+{
+    co_await pool.schedule();
+    threadId = std::this_thread::get_id();
+    co_await pool.schedule(chat::common::ThreadPool::Priority::High);
+    latch.count_down();
+}
+
+struct DestroyedFlag
+{
+    explicit DestroyedFlag(bool& destroyed)
+      : destroyed{destroyed}
+    {}
+
+    DestroyedFlag(const DestroyedFlag& other) = delete;
+    DestroyedFlag& operator=(const DestroyedFlag& other) = delete;
+    DestroyedFlag(DestroyedFlag&& other) = delete;
+    DestroyedFlag& operator=(DestroyedFlag&& other) = delete;
+
+    ~DestroyedFlag()
+    {
+        destroyed = true;
+    }
+
+    bool& destroyed;
+};
+
+DetachedCoroutine waitOnPool(chat::common::ThreadPool& pool, bool& resumed,
+                             bool& destroyed)
+{
+    const DestroyedFlag flag{destroyed};
+    co_await pool.schedule();
+    resumed = true;
+}
+
+void queueRepeatedly(chat::common::ThreadPool& pool, std::atomic_int& count,
+                     int jobCount)
+{
+    pool.queue([&pool, &count, jobCount] {
+        if(++count < jobCount) {
+            queueRepeatedly(pool, count, jobCount);
+        }
+    });
+}
 }
 
 TEST_CASE("Queueing 1 job into a thread pool with no threads", "[ThreadPool]")
@@ -143,3 +228,430 @@ TEST_CASE("Pausing thread pools", "[ThreadPool]")
     REQUIRE(count == 1);
     REQUIRE(elapsed >= WAIT_TIME);
 }
+
+TEST_CASE("Queueing jobs from a job", "[ThreadPool]")
+{
+    constexpr int threadCount = 4;
+    chat::common::ThreadPool pool{threadCount};
+
+    constexpr int jobCount = 1000;
+    std::atomic_int count = 0;
+    pool.queue([&] {
+        for(int i = 0; i < jobCount; i++) {
+            pool.queue([&] { count++; });
+        }
+    });
+    pool.waitForCompletion();
+    REQUIRE(count == jobCount);
+}
+
+TEST_CASE("Queueing jobs from multiple threads", "[ThreadPool]")
+{
+    constexpr int threadCount = 4;
+    chat::common::ThreadPool pool{threadCount};
+
+    constexpr int queueingThreadCount = 4;
+    constexpr int jobCount = 1000;
+    std::atomic_int count = 0;
+    std::vector<std::thread> queueingThreads;
+    queueingThreads.reserve(queueingThreadCount);
+    for(int i = 0; i < queueingThreadCount; i++) {
+        queueingThreads.emplace_back([&] {
+            for(int j = 0; j < jobCount; j++) {
+                pool.queue([&] { count++; });
+            }
+        });
+    }
+
+    for(auto& thread : queueingThreads) {
+        thread.join();
+    }
+    pool.waitForCompletion();
+    REQUIRE(count == queueingThreadCount * jobCount);
+}
+
+TEST_CASE("Pausing thread pools stops jobs queued from jobs", "[ThreadPool]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{threadCount};
+
+    std::atomic_int count = 0;
+    pool.queue([&] {
+        pool.pause();
+        pool.queue([&] { count++; });
+    });
+    std::this_thread::sleep_for(WAIT_TIME);
+    REQUIRE(count == 0);
+
+    pool.resume();
+    pool.waitForCompletion();
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Queueing a job with move-only captures", "[ThreadPool]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+
+    std::atomic_int value = 0;
+    auto pointer = std::make_unique<int>(1);
+    pool.queue([&value, pointer = std::move(pointer)] { value = *pointer; });
+    pool.waitForCompletion();
+    REQUIRE(value == 1);
+}
+
+TEST_CASE("Queueing a batch of jobs", "[ThreadPool]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{threadCount};
+
+    constexpr int jobCount = 100;
+    std::atomic_int count = 0;
+    std::vector<chat::common::Job> jobs;
+    for(int i = 0; i < jobCount; i++) {
+        jobs.emplace_back([&] { count++; });
+    }
+
+    SECTION("Waiting for all jobs")
+    {
+        pool.queue(jobs);
+        pool.waitForCompletion();
+        REQUIRE(count == jobCount);
+    }
+
+    SECTION("Waiting for the batch")
+    {
+        std::latch latch{jobCount};
+        pool.queue(jobs, latch);
+        latch.wait();
+        REQUIRE(count == jobCount);
+    }
+}
+
+TEST_CASE("Running a batch of jobs only waits for the batch", "[ThreadPool]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{threadCount};
+
+    std::atomic_bool release = false;
+    pool.queue([&] {
+        while(!release) {
+            std::this_thread::yield();
+        }
+    });
+
+    constexpr int jobCount = 10;
+    std::atomic_int count = 0;
+    std::vector<chat::common::Job> jobs;
+    for(int i = 0; i < jobCount; i++) {
+        jobs.emplace_back([&] { count++; });
+    }
+    pool.run(jobs);
+    REQUIRE(count == jobCount);
+
+    release = true;
+    pool.waitForCompletion();
+}
+
+TEST_CASE("Running a batch of jobs from a job", "[ThreadPool]")
+{
+    // The only thread runs the batch itself rather than waiting forever
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+
+    constexpr int jobCount = 10;
+    std::atomic_int count = 0;
+    pool.queue([&] {
+        std::vector<chat::common::Job> jobs;
+        for(int i = 0; i < jobCount; i++) {
+            jobs.emplace_back([&] { count++; });
+        }
+        pool.run(jobs);
+    });
+    pool.waitForCompletion();
+    REQUIRE(count == jobCount);
+}
+
+TEST_CASE("High priority jobs run before normal priority jobs", "[ThreadPool]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+    using Priority = chat::common::ThreadPool::Priority;
+
+    std::vector<Priority> order;
+    pool.pause();
+    pool.queue([&] { order.push_back(Priority::Normal); }, Priority::Normal);
+    pool.queue([&] { order.push_back(Priority::High); }, Priority::High);
+    REQUIRE(pool.getQueuedCount(Priority::High) == 1);
+    REQUIRE(pool.getQueuedCount(Priority::Normal) == 1);
+
+    pool.resume();
+    pool.waitForCompletion();
+    REQUIRE(order == std::vector{Priority::High, Priority::Normal});
+    REQUIRE(pool.getQueuedCount(Priority::High) == 0);
+    REQUIRE(pool.getQueuedCount(Priority::Normal) == 0);
+}
+
+TEST_CASE("High priority jobs don't starve normal priority jobs",
+          "[ThreadPool]")
+{
+    constexpr int threadCount = 1;
+    chat::common::ThreadPool pool{threadCount};
+    using Priority = chat::common::ThreadPool::Priority;
+
+    constexpr int highPriorityJobCount = 1000;
+    std::atomic_int highPriorityCount = 0;
+    std::atomic_int highPriorityCountAtNormal = 0;
+    pool.pause();
+    pool.queue([&] { highPriorityCountAtNormal = highPriorityCount.load(); },
+               Priority::Normal);
+    for(int i = 0; i < highPriorityJobCount; i++) {
+        pool.queue([&] { highPriorityCount++; }, Priority::High);
+    }
+
+    pool.resume();
+    pool.waitForCompletion();
+    REQUIRE(highPriorityCount == highPriorityJobCount);
+    REQUIRE(highPriorityCountAtNormal < highPriorityJobCount);
+}
+
+TEST_CASE("Running jobs with the low latency idle policy", "[ThreadPool]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{
+        threadCount, chat::common::ThreadPool::IdlePolicy::lowLatency()};
+
+    constexpr int jobCount = 100;
+    std::atomic_int count = 0;
+    for(int i = 0; i < jobCount; i++) {
+        pool.queue([&] { count++; });
+        pool.waitForCompletion();
+    }
+    REQUIRE(count == jobCount);
+}
+
+TEST_CASE("Scheduling a coroutine onto a thread pool", "[ThreadPool]")
+{
+    chat::common::ThreadPool pool{1};
+
+    std::thread::id threadId;
+    std::latch latch{1};
+    hopOntoPool(pool, threadId, latch);
+    latch.wait();
+    REQUIRE(threadId != std::this_thread::get_id());
+}
+
+TEST_CASE("Destroying a thread pool with a coroutine scheduled onto it",
+          "[ThreadPool]")
+{
+    // The pool has no threads, so the coroutine is never resumed and its frame
+    // is destroyed with the pool
+    bool resumed = false;
+    bool destroyed = false;
+    {
+        chat::common::ThreadPool pool{0};
+        waitOnPool(pool, resumed, destroyed);
+        REQUIRE(!destroyed);
+    }
+    REQUIRE(!resumed);
+    REQUIRE(destroyed);
+}
+
+TEST_CASE("Destroying a thread pool with a job that keeps queueing itself",
+          "[ThreadPool]")
+{
+    // The chain is long enough that running all of it would take far longer
+    // than the test, so the pool must stop without running it all
+    constexpr int jobCount = 100000000;
+    std::atomic_int count = 0;
+    {
+        chat::common::ThreadPool pool{2};
+        queueRepeatedly(pool, count, jobCount);
+        while(count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    REQUIRE(count > 0);
+    REQUIRE(count < jobCount);
+}
+
+TEST_CASE("Queueing a job after a delay", "[ThreadPool]")
+{
+    chat::common::ThreadPool pool{1};
+
+    std::atomic_int count = 0;
+    const auto start = now();
+    std::latch latch{1};
+    pool.queueAfter(WAIT_TIME, [&] {
+        count++;
+        latch.count_down();
+    });
+    latch.wait();
+    REQUIRE(getElapsedTime(start) >= WAIT_TIME);
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Cancelling a delayed job", "[ThreadPool]")
+{
+    chat::common::ThreadPool pool{1};
+
+    std::atomic_int count = 0;
+    const auto timer = pool.queueAfter(WAIT_TIME, [&] { count++; });
+    REQUIRE(pool.cancel(timer));
+    REQUIRE(!pool.cancel(timer));
+
+    std::this_thread::sleep_for(WAIT_TIME * 2);
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("Queueing a job repeatedly", "[ThreadPool]")
+{
+    chat::common::ThreadPool pool{2};
+
+    constexpr int runCount = 5;
+    constexpr std::chrono::milliseconds period{10};
+    std::atomic_int count = 0;
+    std::latch latch{runCount};
+    const auto start = now();
+    const auto timer = pool.queueEvery(period, [&] {
+        if(++count <= runCount) {
+            latch.count_down();
+        }
+    });
+    latch.wait();
+    REQUIRE(getElapsedTime(start) >= period * runCount);
+
+    REQUIRE(pool.cancel(timer));
+    pool.waitForCompletion();
+    const int cancelledCount = count;
+    std::this_thread::sleep_for(period * 5);
+    REQUIRE(count == cancelledCount);
+}
+
+TEST_CASE("Cancelling a repeating job from the job", "[ThreadPool]")
+{
+    chat::common::ThreadPool pool{1};
+
+    std::atomic_int count = 0;
+    std::atomic_bool cancelled = false;
+    std::atomic<chat::common::ThreadPool::TimerId> timer = 0;
+    std::latch latch{1};
+    pool.pause();
+    timer = pool.queueEvery(std::chrono::milliseconds{1}, [&] {
+        count++;
+        cancelled = pool.cancel(timer);
+        latch.count_down();
+    });
+    pool.resume();
+    latch.wait();
+
+    std::this_thread::sleep_for(WAIT_TIME);
+    REQUIRE(cancelled);
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Growing an elastic thread pool while jobs wait", "[ThreadPool]")
+{
+    constexpr std::size_t minThreadCount = 1;
+    constexpr std::size_t maxThreadCount = 3;
+    chat::common::ThreadPool pool{chat::common::ThreadPool::SizingPolicy{
+        .minThreadCount = minThreadCount,
+        .maxThreadCount = maxThreadCount,
+        .targetQueueWait = std::chrono::milliseconds{1},
+        .idleTimeout = WAIT_TIME}};
+    REQUIRE(pool.getThreadCount() == minThreadCount);
+
+    // Every job blocks its thread, so the jobs only all run once the pool has
+    // grown to the max
+    std::latch latch{maxThreadCount};
+    for(std::size_t i = 0; i < maxThreadCount; i++) {
+        pool.queue([&] { latch.arrive_and_wait(); });
+    }
+    pool.waitForCompletion();
+    REQUIRE(pool.getThreadCount() == maxThreadCount);
+    REQUIRE(pool.getThreadStartCount() == maxThreadCount - minThreadCount);
+
+    // The extra threads stop once they have been idle for the timeout
+    const auto start = now();
+    while(pool.getThreadCount() > minThreadCount &&
+          getElapsedTime(start) < WAIT_TIME * 10) {
+        std::this_thread::sleep_for(WAIT_TIME / 10);
+    }
+    REQUIRE(pool.getThreadCount() == minThreadCount);
+    REQUIRE(pool.getThreadRetireCount() == maxThreadCount - minThreadCount);
+
+    // The pool still runs jobs after shrinking
+    std::atomic_int count = 0;
+    pool.queue([&] { count++; });
+    pool.waitForCompletion();
+    REQUIRE(count == 1);
+
+    // Jobs queued after the pool has been idle still make it grow, since
+    // queueing them wakes the timer thread to check on them
+    std::this_thread::sleep_for(WAIT_TIME);
+    std::latch secondLatch{maxThreadCount};
+    for(std::size_t i = 0; i < maxThreadCount; i++) {
+        pool.queue([&] { secondLatch.arrive_and_wait(); });
+    }
+    pool.waitForCompletion();
+    REQUIRE(pool.getThreadStartCount() ==
+            (maxThreadCount - minThreadCount) * 2);
+}
+
+TEST_CASE("Reading the statistics of a thread pool", "[ThreadPool]")
+{
+    constexpr int threadCount = 2;
+    chat::common::ThreadPool pool{threadCount};
+
+    constexpr int jobCount = 10;
+    pool.pause();
+    for(int i = 0; i < jobCount; i++) {
+        pool.queue([] {});
+    }
+    pool.queue([] { throw std::runtime_error{"failure"}; });
+    pool.queue([] { std::this_thread::sleep_for(WAIT_TIME); });
+    pool.resume();
+    pool.waitForCompletion();
+
+    const auto stats = pool.getStats();
+    REQUIRE(stats.queueWait.getCount() == jobCount + 2);
+    REQUIRE(stats.runTime.getCount() == jobCount + 2);
+    REQUIRE(stats.runTime.getPercentile(100) >=
+            static_cast<std::uint64_t>(
+                std::chrono::nanoseconds{WAIT_TIME}.count()));
+    REQUIRE(stats.maxQueuedCount == jobCount + 2);
+    REQUIRE(stats.exceptionCount == 1);
+}
+
+TEST_CASE("The most queued jobs never exceeds the jobs queued",
+          "[ThreadPool]")
+{
+    constexpr int threadCount = 4;
+    chat::common::ThreadPool pool{threadCount};
+
+    // Jobs queued by the pool's own threads go into their deques, where other
+    // threads steal them while more are being queued
+    constexpr int queueingJobCount = 8;
+    constexpr int batchCount = 100;
+    constexpr int batchSize = 64;
+    std::atomic_int count = 0;
+    for(int i = 0; i < queueingJobCount; i++) {
+        pool.queue([&] {
+            for(int j = 0; j < batchCount; j++) {
+                std::vector<chat::common::Job> jobs;
+                for(int k = 0; k < batchSize; k++) {
+                    jobs.emplace_back([&] { count++; });
+                }
+                pool.queue(jobs);
+            }
+        });
+    }
+    pool.waitForCompletion();
+
+    constexpr int jobCount =
+        queueingJobCount + (queueingJobCount * batchCount * batchSize);
+    REQUIRE(count == queueingJobCount * batchCount * batchSize);
+    REQUIRE(pool.getStats().maxQueuedCount <= jobCount);
+    REQUIRE(pool.getQueuedCount(chat::common::ThreadPool::Priority::Normal) ==
+            0);
+}
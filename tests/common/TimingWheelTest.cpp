@@ -0,0 +1,168 @@
+#include "chat/common/TimingWheel.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Wheel = chat::common::TimingWheel<std::string>;
+}
+
+TEST_CASE("Expiring a timer of a timing wheel", "[TimingWheel]")
+{
+    Wheel wheel;
+    const auto key = wheel.insert(10, "timer");
+    REQUIRE(wheel.getNextTick() == 10);
+
+    std::vector<Wheel::Key> expired;
+    wheel.advance(9, expired);
+    REQUIRE(expired.empty());
+
+    wheel.advance(10, expired);
+    REQUIRE(expired == std::vector{key});
+    REQUIRE(wheel.getTick() == 10);
+    REQUIRE(!wheel.getNextTick().has_value());
+
+    // An expired timer stays until it's erased
+    REQUIRE(wheel.find(key) != nullptr);
+    REQUIRE(*wheel.find(key) == "timer");
+    REQUIRE(wheel.erase(key));
+    REQUIRE(wheel.empty());
+}
+
+TEST_CASE("Erasing a timer of a timing wheel", "[TimingWheel]")
+{
+    Wheel wheel;
+    const auto key = wheel.insert(10, "timer");
+    REQUIRE(wheel.erase(key));
+    REQUIRE(!wheel.erase(key));
+    REQUIRE(wheel.find(key) == nullptr);
+
+    std::vector<Wheel::Key> expired;
+    wheel.advance(10, expired);
+    REQUIRE(expired.empty());
+}
+
+TEST_CASE("Expiring a timer that is already due", "[TimingWheel]")
+{
+    constexpr std::uint64_t start = 100;
+    Wheel wheel{start};
+    const auto key = wheel.insert(start - 1, "timer");
+
+    std::vector<Wheel::Key> expired;
+    wheel.advance(start + 1, expired);
+    REQUIRE(expired == std::vector{key});
+}
+
+TEST_CASE("Expiring timers of every level of a timing wheel",
+          "[TimingWheel]")
+{
+    // The ticks are spread over every level, and the wheel starts partway
+    // through a turn so that the levels are moved down at different ticks
+    constexpr std::uint64_t start = 0x1234;
+    const std::vector<std::uint64_t> ticks = {
+        start + 1,         start + 0xFF,      start + 0x100,
+        start + 0xABCD,    start + 0x10000,   start + 0x123456,
+        start + 0x1000000, start + 0x3000007,
+    };
+
+    Wheel wheel{start};
+    std::vector<Wheel::Key> keys;
+    for(const auto tick : ticks) {
+        keys.push_back(wheel.insert(tick, std::to_string(tick)));
+    }
+
+    // Each timer expires exactly at its tick, never before
+    std::vector<Wheel::Key> expired;
+    for(std::size_t i = 0; i < ticks.size(); i++) {
+        wheel.advance(ticks.at(i) - 1, expired);
+        REQUIRE(expired.empty());
+
+        wheel.advance(ticks.at(i), expired);
+        REQUIRE(expired == std::vector{keys.at(i)});
+        REQUIRE(*wheel.find(keys.at(i)) == std::to_string(ticks.at(i)));
+        expired.clear();
+    }
+}
+
+TEST_CASE("Expiring timers on the boundaries of the levels of a timing wheel",
+          "[TimingWheel]")
+{
+    // The timers are moved down a level on the same tick they expire at
+    const std::vector<std::uint64_t> ticks = {0x100, 0x200, 0x10000};
+
+    Wheel wheel;
+    std::vector<Wheel::Key> keys;
+    for(const auto tick : ticks) {
+        keys.push_back(wheel.insert(tick, std::to_string(tick)));
+    }
+
+    std::vector<Wheel::Key> expired;
+    for(std::size_t i = 0; i < ticks.size(); i++) {
+        wheel.advance(ticks.at(i) - 1, expired);
+        REQUIRE(expired.empty());
+
+        wheel.advance(ticks.at(i), expired);
+        REQUIRE(expired == std::vector{keys.at(i)});
+        expired.clear();
+    }
+}
+
+TEST_CASE("Expiring a timer beyond the top level of a timing wheel",
+          "[TimingWheel]")
+{
+    constexpr std::uint64_t start = 0xFFFFFF00;
+    constexpr std::uint64_t tick = start + 0x100000010;
+    Wheel wheel{start};
+    const auto key = wheel.insert(tick, "timer");
+
+    std::vector<Wheel::Key> expired;
+    wheel.advance(tick - 1, expired);
+    REQUIRE(expired.empty());
+
+    wheel.advance(tick, expired);
+    REQUIRE(expired == std::vector{key});
+}
+
+TEST_CASE("Rescheduling a timer of a timing wheel", "[TimingWheel]")
+{
+    Wheel wheel;
+    const auto key = wheel.insert(10, "timer");
+
+    SECTION("Rescheduling a waiting timer")
+    {
+        REQUIRE(wheel.reschedule(key, 20));
+
+        std::vector<Wheel::Key> expired;
+        wheel.advance(19, expired);
+        REQUIRE(expired.empty());
+        wheel.advance(20, expired);
+        REQUIRE(expired == std::vector{key});
+    }
+
+    SECTION("Rescheduling an expired timer")
+    {
+        std::vector<Wheel::Key> expired;
+        wheel.advance(10, expired);
+        REQUIRE(expired == std::vector{key});
+
+        expired.clear();
+        REQUIRE(wheel.reschedule(key, 20));
+        wheel.advance(20, expired);
+        REQUIRE(expired == std::vector{key});
+    }
+}
+
+TEST_CASE("Getting the next tick of a timing wheel", "[TimingWheel]")
+{
+    Wheel wheel;
+    REQUIRE(!wheel.getNextTick().has_value());
+
+    // A timer on a higher level is only looked at once the first level wraps
+    // around
+    static_cast<void>(wheel.insert(1000, "timer"));
+    REQUIRE(wheel.getNextTick() == 256);
+}
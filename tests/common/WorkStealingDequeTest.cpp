@@ -0,0 +1,121 @@
+#include "chat/common/WorkStealingDeque.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Popping from an empty work-stealing deque", "[WorkStealingDeque]")
+{
+    chat::common::WorkStealingDeque<int> deque;
+    REQUIRE(deque.empty());
+    REQUIRE(!deque.pop().has_value());
+    REQUIRE(!deque.steal().has_value());
+}
+
+TEST_CASE("Popping from a work-stealing deque is last-in-first-out",
+          "[WorkStealingDeque]")
+{
+    chat::common::WorkStealingDeque<int> deque;
+    constexpr int count = 3;
+    for(int i = 0; i < count; i++) {
+        deque.push(i);
+    }
+
+    for(int i = count - 1; i >= 0; i--) {
+        const auto value = deque.pop();
+        REQUIRE(value.has_value());
+        REQUIRE(value.value() == i);
+    }
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("Stealing from a work-stealing deque is first-in-first-out",
+          "[WorkStealingDeque]")
+{
+    chat::common::WorkStealingDeque<int> deque;
+    constexpr int count = 3;
+    for(int i = 0; i < count; i++) {
+        deque.push(i);
+    }
+
+    for(int i = 0; i < count; i++) {
+        const auto value = deque.steal();
+        REQUIRE(value.has_value());
+        REQUIRE(value.value() == i);
+    }
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("Growing a work-stealing deque", "[WorkStealingDeque]")
+{
+    chat::common::WorkStealingDeque<int> deque{2};
+
+    // Moves the positions away from the start of the array before growing
+    deque.push(-1);
+    REQUIRE(deque.steal().value() == -1);
+
+    constexpr int count = 100;
+    for(int i = 0; i < count; i++) {
+        deque.push(i);
+    }
+
+    REQUIRE(deque.steal().value() == 0);
+    for(int i = count - 1; i > 0; i--) {
+        REQUIRE(deque.pop().value() == i);
+    }
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("Stealing from a work-stealing deque while the owner pops",
+          "[WorkStealingDeque]")
+{
+    constexpr std::size_t count = 100'000;
+    constexpr std::size_t thiefCount = 3;
+    chat::common::WorkStealingDeque<std::size_t> deque{16};
+    std::vector<std::atomic_int> taken(count);
+    std::atomic_size_t takenCount = 0;
+    auto take = [&](std::size_t value) {
+        taken.at(value)++;
+        takenCount++;
+    };
+
+    std::vector<std::thread> thieves;
+    thieves.reserve(thiefCount);
+    for(std::size_t i = 0; i < thiefCount; i++) {
+        thieves.emplace_back([&] {
+            while(takenCount < count) {
+                if(const auto value = deque.steal()) {
+                    take(value.value());
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for(std::size_t i = 0; i < count; i++) {
+        deque.push(i);
+        if(i % 2 == 0) {
+            if(const auto value = deque.pop()) {
+                take(value.value());
+            }
+        }
+    }
+
+    while(const auto value = deque.pop()) {
+        take(value.value());
+    }
+
+    for(auto& thief : thieves) {
+        thief.join();
+    }
+
+    // Every value was taken by exactly one thread
+    REQUIRE(std::ranges::all_of(taken, [](const auto& takenCountOfValue) {
+        return takenCountOfValue == 1;
+    }));
+}
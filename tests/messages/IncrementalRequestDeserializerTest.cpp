@@ -1,4 +1,6 @@
+#include "chat/common/Buffer.hpp"
 #include "chat/common/BufferView.hpp"
+#include "chat/common/Result.hpp"
 #include "chat/messages/IncrementalRequestDeserializer.hpp"
 #include "chat/messages/request/Ping.hpp"
 #include "chat/messages/serialize.hpp"
@@ -7,6 +9,8 @@
 
 #include <array>
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 TEST_CASE("Incrementally deserializing a serialized request as a whole",
           "[IncrementalRequestDeserializer]")
@@ -62,6 +66,14 @@ TEST_CASE("Incrementally deserializing a serialized request in chunks",
     REQUIRE(!result.hasValue());
     REQUIRE(result.getError() == FailureReason::Partial);
 
+    // The correlation ID
+    chunkOffset += chunkSize;
+    chunkSize = 4;
+    chunk = serializedView.subspan(chunkOffset, chunkSize);
+    result = deserializer.tryDeserialize(chunk);
+    REQUIRE(!result.hasValue());
+    REQUIRE(result.getError() == FailureReason::Partial);
+
     chunkOffset += chunkSize;
     chunkSize = 1;
     chunk = serializedView.subspan(chunkOffset, chunkSize);
@@ -89,3 +101,143 @@ TEST_CASE("Incrementally deserializing an invalid serialized request",
     REQUIRE(!result.hasValue());
     REQUIRE(result.getError() == FailureReason::Error);
 }
+
+TEST_CASE("Deserializing multiple serialized requests in place",
+          "[IncrementalRequestDeserializer]")
+{
+    using FailureReason =
+        chat::messages::IncrementalRequestDeserializer::FailureReason;
+
+    const chat::messages::Ping message;
+    const auto serialized = chat::messages::serialize(message);
+    chat::common::Buffer data;
+    constexpr int messageCount = 3;
+    for(int i = 0; i < messageCount; i++) {
+        data.insert(data.end(), serialized.begin(), serialized.end());
+    }
+    // Leave the last request incomplete
+    data.insert(data.end(), serialized.begin(), serialized.end() - 1);
+
+    chat::messages::IncrementalRequestDeserializer deserializer;
+    chat::common::BufferView view{data.data(), data.size()};
+    for(int i = 0; i < messageCount; i++) {
+        const auto result = deserializer.tryDeserializeInPlace(view);
+        REQUIRE(result.hasValue());
+        REQUIRE(result.getValue()->getType() ==
+                chat::messages::Request::Type::Ping);
+        REQUIRE(view.size() == data.size() - (serialized.size() * (i + 1)));
+    }
+
+    auto result = deserializer.tryDeserializeInPlace(view);
+    REQUIRE(!result.hasValue());
+    REQUIRE(result.getError() == FailureReason::Partial);
+    REQUIRE(view.empty());
+
+    chat::common::BufferView rest{&serialized.back(), 1};
+    result = deserializer.tryDeserializeInPlace(rest);
+    REQUIRE(result.hasValue());
+    REQUIRE(result.getValue()->getType() ==
+            chat::messages::Request::Type::Ping);
+    REQUIRE(rest.empty());
+}
+
+TEST_CASE("Deserializing in place only uses the bytes of one request",
+          "[IncrementalRequestDeserializer]")
+{
+    const chat::messages::Ping message;
+    const auto serialized = chat::messages::serialize(message);
+    chat::common::Buffer data{serialized.begin() + 1, serialized.end()};
+    data.insert(data.end(), serialized.begin(), serialized.end());
+
+    chat::messages::IncrementalRequestDeserializer deserializer;
+    chat::common::BufferView first{serialized.data(), 1};
+    auto result = deserializer.tryDeserializeInPlace(first);
+    REQUIRE(!result.hasValue());
+
+    chat::common::BufferView view{data.data(), data.size()};
+    result = deserializer.tryDeserializeInPlace(view);
+    REQUIRE(result.hasValue());
+    REQUIRE(view.size() == serialized.size());
+
+    result = deserializer.tryDeserializeInPlace(view);
+    REQUIRE(result.hasValue());
+    REQUIRE(view.empty());
+}
+
+TEST_CASE("Deserializing all serialized requests at once",
+          "[IncrementalRequestDeserializer]")
+{
+    using FailureReason =
+        chat::messages::IncrementalRequestDeserializer::FailureReason;
+
+    const chat::messages::Ping message;
+    const auto serialized = chat::messages::serialize(message);
+    constexpr auto invalid = std::array{
+        std::byte{0x0}, std::byte{0x0},  std::byte{0x0},
+        std::byte{0x1}, std::byte{0xFF},
+    };
+
+    constexpr std::size_t messageCount = 100;
+    chat::common::Buffer data;
+    for(std::size_t i = 0; i < messageCount; i++) {
+        data.insert(data.end(), serialized.begin(), serialized.end());
+    }
+    data.insert(data.end(), invalid.begin(), invalid.end());
+    data.insert(data.end(), serialized.begin(), serialized.end());
+
+    // Split the data in the middle of a request
+    const std::size_t splitIndex = serialized.size() * (messageCount / 2) + 2;
+    const chat::common::BufferView view{data.data(), data.size()};
+
+    chat::messages::IncrementalRequestDeserializer deserializer;
+    std::vector<chat::common::Result<std::unique_ptr<chat::messages::Request>,
+                                     FailureReason>>
+        requests;
+    deserializer.deserializeAll(view.first(splitIndex), requests);
+    REQUIRE(requests.size() == messageCount / 2);
+
+    deserializer.deserializeAll(view.subspan(splitIndex), requests);
+    REQUIRE(requests.size() == messageCount + 2);
+    for(std::size_t i = 0; i < requests.size(); i++) {
+        if(i == messageCount) {
+            REQUIRE(!requests.at(i).hasValue());
+            REQUIRE(requests.at(i).getError() == FailureReason::Error);
+        } else {
+            REQUIRE(requests.at(i).hasValue());
+            REQUIRE(requests.at(i).getValue()->getType() ==
+                    chat::messages::Request::Type::Ping);
+        }
+    }
+}
+
+TEST_CASE("Incrementally deserializing buffered serialized requests",
+          "[IncrementalRequestDeserializer]")
+{
+    using FailureReason =
+        chat::messages::IncrementalRequestDeserializer::FailureReason;
+
+    const chat::messages::Ping message;
+    const auto serialized = chat::messages::serialize(message);
+    constexpr int messageCount = 3;
+    chat::common::Buffer data;
+    for(int i = 0; i < messageCount; i++) {
+        data.insert(data.end(), serialized.begin(), serialized.end());
+    }
+
+    chat::messages::IncrementalRequestDeserializer deserializer;
+    auto result = deserializer.tryDeserialize(
+        chat::common::BufferView{data.data(), data.size()});
+    REQUIRE(result.hasValue());
+
+    // The remaining requests were kept by the deserializer
+    for(int i = 1; i < messageCount; i++) {
+        result = deserializer.tryDeserialize(chat::common::BufferView{});
+        REQUIRE(result.hasValue());
+        REQUIRE(result.getValue()->getType() ==
+                chat::messages::Request::Type::Ping);
+    }
+
+    result = deserializer.tryDeserialize(chat::common::BufferView{});
+    REQUIRE(!result.hasValue());
+    REQUIRE(result.getError() == FailureReason::Partial);
+}
@@ -1,4 +1,5 @@
 #include "chat/common/BufferView.hpp"
+#include "chat/messages/CorrelationId.hpp"
 #include "chat/messages/request/Ping.hpp"
 #include "chat/messages/response/Pong.hpp"
 #include "chat/messages/serialize.hpp"
@@ -28,3 +29,30 @@ TEST_CASE("Using the serializer on a pong response", "[serialize]")
     REQUIRE(deserialized.value()->getType() ==
             chat::messages::Response::Type::Pong);
 }
+
+TEST_CASE("Using the serializer keeps the correlation ID", "[serialize]")
+{
+    constexpr chat::messages::CorrelationId correlationId = 0x01020304;
+
+    SECTION("Request")
+    {
+        chat::messages::Ping request;
+        request.setCorrelationId(correlationId);
+        auto serialized = chat::messages::serialize(request);
+        auto deserialized = chat::messages::deserializeRequest(
+            chat::common::BufferView{serialized.data(), serialized.size()});
+        REQUIRE(deserialized.has_value());
+        REQUIRE(deserialized.value()->getCorrelationId() == correlationId);
+    }
+
+    SECTION("Response")
+    {
+        chat::messages::Pong response;
+        response.setCorrelationId(correlationId);
+        auto serialized = chat::messages::serialize(response);
+        auto deserialized = chat::messages::deserializeResponse(
+            chat::common::BufferView{serialized.data(), serialized.size()});
+        REQUIRE(deserialized.has_value());
+        REQUIRE(deserialized.value()->getCorrelationId() == correlationId);
+    }
+}
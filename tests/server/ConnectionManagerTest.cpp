@@ -0,0 +1,32 @@
+#include "ConnectionManager.hpp"
+#include "Counters.hpp"
+
+#include "chat/common/ThreadPool.hpp"
+#include "chat/server/Config.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+
+#include <limits>
+
+TEST_CASE("Failing to create a connection", "[ConnectionManager]")
+{
+    asio::io_context ioContext;
+    chat::common::ThreadPool threadPool{0};
+    chat::server::Counters counters;
+
+    // The receive buffer is too large to allocate, so constructing the
+    // connection throws
+    chat::server::Config config;
+    config.minReceiveBufferSize = std::numeric_limits<std::size_t>::max();
+    config.maxReceiveBufferSize = std::numeric_limits<std::size_t>::max();
+    chat::server::ConnectionManager connectionManager{threadPool, config,
+                                                      counters};
+
+    REQUIRE_THROWS(connectionManager.start(asio::ip::tcp::socket{ioContext}));
+    REQUIRE(connectionManager.getCount() == 0);
+    connectionManager.stopAll();
+    REQUIRE(connectionManager.getCount() == 0);
+}
@@ -0,0 +1,112 @@
+#include "ConnectionManager.hpp"
+#include "Counters.hpp"
+
+#include "chat/common/Buffer.hpp"
+#include "chat/common/ThreadPool.hpp"
+#include "chat/messages/request/Ping.hpp"
+#include "chat/messages/response/Pong.hpp"
+#include "chat/messages/serialize.hpp"
+#include "chat/server/Config.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <asio/buffer.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/address_v4.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/post.hpp>
+#include <asio/read.hpp>
+#include <asio/socket_base.hpp>
+#include <asio/write.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+namespace
+{
+constexpr auto WAIT_TIME = std::chrono::seconds{5};
+
+template<typename Predicate>
+bool waitUntil(Predicate predicate)
+{
+    const auto deadline = std::chrono::steady_clock::now() + WAIT_TIME;
+    while(!predicate()) {
+        if(std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return true;
+}
+}
+
+TEST_CASE("Crossing the send water marks of a connection", "[Connection]")
+{
+    // The connection's users are destroyed before the context its socket uses
+    asio::io_context ioContext;
+    chat::server::Counters counters;
+    chat::server::Config config;
+    config.receiveRingCapacity = 4096;
+    config.sendHighWaterMark = 4096;
+    config.sendLowWaterMark = 1024;
+    chat::common::ThreadPool threadPool{1};
+    chat::server::ConnectionManager connectionManager{threadPool, config,
+                                                      counters};
+
+    // Small socket buffers make the responses back up into the connection
+    // rather than into the kernel
+    asio::ip::tcp::acceptor acceptor{
+        ioContext,
+        asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+    asio::ip::tcp::socket client{ioContext};
+    client.open(asio::ip::tcp::v4());
+    client.set_option(asio::socket_base::receive_buffer_size{4096});
+    client.set_option(asio::socket_base::send_buffer_size{4096});
+    client.connect(acceptor.local_endpoint());
+    auto server = acceptor.accept();
+    server.set_option(asio::socket_base::receive_buffer_size{4096});
+    server.set_option(asio::socket_base::send_buffer_size{4096});
+
+    auto work = asio::make_work_guard(ioContext);
+    std::thread ioThread{[&] { ioContext.run(); }};
+    asio::post(ioContext, [&] { connectionManager.start(std::move(server)); });
+
+    // The client sends far more pings than the buffers along the way hold,
+    // and only reads the responses once the connection has stopped receiving
+    constexpr std::size_t pingCount = 100000;
+    const auto ping = chat::messages::serialize(chat::messages::Ping{});
+    const std::size_t pongSize =
+        chat::messages::serialize(chat::messages::Pong{}).size();
+    chat::common::Buffer pings;
+    pings.reserve(ping.size() * pingCount);
+    for(std::size_t i = 0; i < pingCount; i++) {
+        pings.insert(pings.end(), ping.begin(), ping.end());
+    }
+    std::thread writer{[&] { asio::write(client, asio::buffer(pings)); }};
+
+    REQUIRE(waitUntil([&] {
+        return counters.getStats().sendBlockedConnectionCount == 1;
+    }));
+    auto stats = counters.getStats();
+    REQUIRE(stats.sendBlockCount >= 1);
+    REQUIRE(stats.queuedSendBytes >= config.sendHighWaterMark);
+
+    // Reading the responses lets the connection send its queued bytes, and
+    // falling to the low water mark resumes receiving, so every ping is
+    // answered
+    chat::common::Buffer pongs(pongSize * pingCount);
+    asio::read(client, asio::buffer(pongs));
+    writer.join();
+    REQUIRE(waitUntil([&] {
+        const auto current = counters.getStats();
+        return current.queuedSendBytes == 0 &&
+               current.sendBlockedConnectionCount == 0;
+    }));
+
+    asio::post(ioContext, [&] { connectionManager.stopAll(); });
+    work.reset();
+    ioThread.join();
+    threadPool.waitForCompletion();
+}
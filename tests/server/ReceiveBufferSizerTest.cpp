@@ -0,0 +1,74 @@
+#include "ReceiveBufferSizer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+
+TEST_CASE("Constructing a receive buffer sizer", "[ReceiveBufferSizer]")
+{
+    using chat::server::ReceiveBufferSizer;
+
+    const ReceiveBufferSizer sizer{256, 4096};
+    REQUIRE(sizer.getSize() == 256);
+    REQUIRE(sizer.getMinSize() == 256);
+
+    REQUIRE_THROWS_AS((ReceiveBufferSizer{0, 4096}), std::invalid_argument);
+    REQUIRE_THROWS_AS((ReceiveBufferSizer{512, 256}), std::invalid_argument);
+}
+
+TEST_CASE("Growing a receive buffer", "[ReceiveBufferSizer]")
+{
+    chat::server::ReceiveBufferSizer sizer{256, 1024};
+
+    // Each receive that fills the buffer doubles it, up to the max
+    REQUIRE(sizer.recordReceive(256));
+    REQUIRE(sizer.getSize() == 512);
+    REQUIRE(sizer.recordReceive(512));
+    REQUIRE(sizer.getSize() == 1024);
+    REQUIRE_FALSE(sizer.recordReceive(1024));
+    REQUIRE(sizer.getSize() == 1024);
+}
+
+TEST_CASE("Shrinking a receive buffer", "[ReceiveBufferSizer]")
+{
+    chat::server::ReceiveBufferSizer sizer{256, 4096};
+    sizer.recordReceive(256);
+    sizer.recordReceive(512);
+    sizer.recordReceive(1024);
+    sizer.recordReceive(2048);
+    REQUIRE(sizer.getSize() == 4096);
+
+    SECTION("Small receives in a row shrink it to fit the largest of them")
+    {
+        for(int i = 0; i < 7; i++) {
+            REQUIRE_FALSE(sizer.recordReceive(i == 3 ? 600 : 100));
+            REQUIRE(sizer.getSize() == 4096);
+        }
+
+        REQUIRE(sizer.recordReceive(100));
+        REQUIRE(sizer.getSize() == 1024);
+    }
+
+    SECTION("It never shrinks below the min")
+    {
+        for(int i = 0; i < 8; i++) {
+            sizer.recordReceive(1);
+        }
+        REQUIRE(sizer.getSize() == 256);
+    }
+
+    SECTION("A receive that uses more than half of it keeps its size")
+    {
+        for(int i = 0; i < 20; i++) {
+            REQUIRE_FALSE(sizer.recordReceive(i % 4 == 0 ? 3000 : 100));
+        }
+        REQUIRE(sizer.getSize() == 4096);
+    }
+
+    SECTION("An idle connection shrinks it to the min")
+    {
+        REQUIRE(sizer.shrinkForIdle());
+        REQUIRE(sizer.getSize() == 256);
+        REQUIRE_FALSE(sizer.shrinkForIdle());
+    }
+}
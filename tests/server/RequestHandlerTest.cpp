@@ -14,3 +14,11 @@ TEST_CASE("Handling a ping request", "[RequestHandler]")
     auto* casted = dynamic_cast<const chat::messages::Pong*>(response.get());
     REQUIRE(casted != nullptr);
 }
+
+TEST_CASE("Checking if a ping request can be handled concurrently",
+          "[RequestHandler]")
+{
+    const chat::server::RequestHandler handler;
+    const chat::messages::Ping request;
+    REQUIRE(handler.isConcurrent(request));
+}